@@ -2,23 +2,40 @@
 #include "imgui/imgui.h"
 #include "classes/TicTacToe.h"
 #include "classes/Logger.h"
+#include <thread>
 
 namespace ClassGame {
         //
         // our global variables
         //
         Logger& logger = Logger::GetInstance();
-        TicTacToe *game = nullptr;
+        MNKGameBase *game = nullptr;
         bool gameOver = false;
         int gameWinner = -1;
 
+        // the m,n,k games that can be picked in the settings window
+        const char *boardNames[] = { "Tic Tac Toe (3x3, 3 in a row)", "4x4, 4 in a row", "7x6, 4 in a row", "Gomoku (15x15, 5 in a row)" };
+        int boardIndex = 0;
+
+        MNKGameBase *CreateGame(int index)
+        {
+            switch (index)
+            {
+                case 1:  return new MNKGame<4, 4, 4>();
+                case 2:  return new MNKGame<7, 6, 4>();
+                case 3:  return new MNKGame<15, 15, 5>();
+                default: return new TicTacToe();
+            }
+        }
+
         //
         // game starting point
         // this is called by the main render loop in main.cpp
         //
         void GameStartUp() 
         {
-            game = new TicTacToe();
+            MapGameData();
+            game = CreateGame(boardIndex);
             game->setUpBoard();
             logger.Info("Game started");
         }
@@ -45,8 +62,106 @@ namespace ClassGame {
                 if (!game->getCurrentPlayer()) return;
                 
                 ImGui::Begin("Settings");
+                // a new board size is a new game, the old one is stopped (and its search cancelled) first
+                if (ImGui::Combo("Board", &boardIndex, boardNames, IM_ARRAYSIZE(boardNames))) {
+                    game->stopGame();
+                    delete game;
+                    game = CreateGame(boardIndex);
+                    game->setUpBoard();
+                    gameOver = false;
+                    gameWinner = -1;
+                    logger.Info(std::string("Started a new game of ") + boardNames[boardIndex]);
+                }
                 ImGui::Text("Current Player Number: %d", game->getCurrentPlayer()->playerNumber());
-                ImGui::Text("Current Board State: %s", game->stateString().c_str());
+                ImGui::TextWrapped("Current Board State: %s", game->stateString().c_str());
+                int solvedValue = 0, pliesToEnd = 0, solvedMove = -1;
+                if (game->solvedPosition(solvedValue, pliesToEnd, solvedMove)) {
+                    ImGui::Text("Solved Value: %s in %d, Best Move: %d",
+                                solvedValue > 0 ? "Win" : solvedValue < 0 ? "Loss" : "Draw", pliesToEnd, solvedMove);
+                    ImGui::Checkbox("Use Solved Table", &game->_gameOptions.AIUseSolvedTable);
+                }
+                if (game->openingBookSize() > 0) {
+                    ImGui::Checkbox("Use Opening Book", &game->_gameOptions.AIUseOpeningBook);
+                    ImGui::SameLine();
+                    ImGui::Text("(%llu positions)", (unsigned long long)game->openingBookSize());
+                }
+                ImGui::Checkbox("Search In Background", &game->_gameOptions.AIRunAsync);
+                ImGui::SliderInt("AI Max Depth", &game->_gameOptions.AIMAXDepth, 1, game->cellCount());
+                ImGui::SliderInt("AI Time Budget (ms)", &game->_gameOptions.AITimeBudgetMs, 0, 5000);
+                ImGui::SliderInt("AI Threads (0 = all)", &game->_gameOptions.AIThreads, 0, (int)std::thread::hardware_concurrency());
+                ImGui::Checkbox("Use Monte Carlo Tree Search", &game->_gameOptions.AIUseMCTS);
+                if (game->_gameOptions.AIUseMCTS) {
+                    ImGui::SliderInt("MCTS Playouts (0 = time budget)", &game->_gameOptions.AIMCTSPlayouts, 0, 200000);
+                }
+                ImGui::Checkbox("Look For Threat Wins First", &game->_gameOptions.AIUseThreatSearch);
+                if (game->_gameOptions.AIUseThreatSearch) {
+                    ImGui::SliderInt("Threat Search Depth (threats)", &game->_gameOptions.AIThreatDepth, 1, 16);
+                }
+                ImGui::Checkbox("Prove Wins First", &game->_gameOptions.AIUseProofSearch);
+                if (game->_gameOptions.AIUseProofSearch) {
+                    ImGui::SliderInt("Proof Search Nodes", &game->_gameOptions.AIProofNodes, 1000, 1000000, "%d", ImGuiSliderFlags_Logarithmic);
+                }
+                ImGui::Checkbox("Ponder On Your Turn", &game->_gameOptions.AIPonder);
+                const PonderStats &ponderStats = game->ponderStats();
+                ImGui::Text("Ponder: %d replies ready last turn, %d hits, %d misses", ponderStats.replies, ponderStats.hits, ponderStats.misses);
+                const char spinner[] = "|/-\\";
+                if (game->isAIThinking()) {
+                    // the search stats belong to the worker until it finishes
+                    ImGui::Text("AI is thinking... %c", spinner[(int)(ImGui::GetTime() * 8) % 4]);
+                } else {
+                    // pondering has engines of its own, so the last turn's stats are still the ones to show
+                    if (game->isPondering()) ImGui::Text("AI is pondering your move... %c", spinner[(int)(ImGui::GetTime() * 8) % 4]);
+                    const SearchStats &stats = game->searchStats();
+                    ImGui::Text("Last AI Search: depth %d (max ply %d) in %.2f ms", stats.completedDepth, stats.maxDepth, stats.elapsedMs);
+                    ImGui::Text("  Nodes: %llu (%.0f per second)", (unsigned long long)stats.nodes, stats.nodesPerSecond());
+                    if (stats.playouts > 0) {
+                        ImGui::Text("  Playouts: %llu (%.0f per second)", (unsigned long long)stats.playouts, stats.playoutsPerSecond());
+                    }
+                    ImGui::Text("  Leaf Evaluations: %llu, Terminal: %llu, Cutoffs: %llu",
+                                (unsigned long long)stats.leafEvaluations, (unsigned long long)stats.terminalHits,
+                                (unsigned long long)stats.cutoffs);
+                    ImGui::Text("  Transposition Table: %llu hits, %llu misses, %d positions stored",
+                                (unsigned long long)stats.tableHits, (unsigned long long)stats.tableMisses,
+                                game->transpositionTable().usedEntries());
+                    const std::vector<SearchStats> &threadStats = game->threadStats();
+                    for (size_t i = 0; i < threadStats.size() && threadStats.size() > 1; i++) {
+                        if (threadStats[i].playouts > 0) {
+                            ImGui::Text("  Thread %d: %llu playouts in %.2f ms", (int)i, (unsigned long long)threadStats[i].playouts, threadStats[i].elapsedMs);
+                        } else {
+                            ImGui::Text("  Thread %d: %llu nodes in %.2f ms", (int)i, (unsigned long long)threadStats[i].nodes, threadStats[i].elapsedMs);
+                        }
+                    }
+                    if (ImGui::Button("Export Search Stats")) {
+                        std::filesystem::path filePath = std::filesystem::current_path() / "search_stats.csv";
+                        if (WriteSearchRecords(game->searchRecords(), filePath)) logger.Info("Search stats saved to " + filePath.string());
+                        else logger.Error("Could not write " + filePath.string());
+                    }
+                    ImGui::SameLine();
+                    ImGui::Text("%d moves recorded", (int)game->searchRecords().size());
+
+                    std::vector<int> principalVariation = game->principalVariation();
+                    if (!principalVariation.empty()) {
+                        std::string line;
+                        for (int cell : principalVariation) line += std::to_string(cell) + " ";
+                        ImGui::TextWrapped("Principal Variation (score %d): %s", game->principalScore(), line.c_str());
+                    }
+                    ImGui::Text("  Carried over into %d AI turns", game->continuedLines());
+
+                    const char *outcomes[] = { "Unknown", "Win", "Loss", "Draw", "No Forced Win" };
+                    const ProofResult *proofs[] = { &game->threatResult(), &game->proofResult() };
+                    const char *proofNames[] = { "Threat Search", "Proof Search" };
+                    for (int i = 0; i < 2; i++) {
+                        const ProofResult &proof = *proofs[i];
+                        if (proof.playerNumber < 0) continue;
+                        ImGui::Text("%s: %s for player %d (%llu nodes in %.2f ms)", proofNames[i], outcomes[proof.outcome], proof.playerNumber,
+                                    (unsigned long long)proof.nodes, proof.elapsedMs);
+                        if (!proof.line.empty()) {
+                            std::string line;
+                            for (int cell : proof.line) line += std::to_string(cell) + " ";
+                            ImGui::TextWrapped("  Proven Line: %s", line.c_str());
+                        }
+                    }
+                }
 
                 if (gameOver) {
                     ImGui::Text("Game Over!");
@@ -0,0 +1,87 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "MNKBoard.h"
+
+namespace MNKTables
+{
+    //
+    // where cell i of a W x H board ends up under each symmetry
+    // a square board has all 8 rotations and reflections, any other rectangle only keeps the
+    // 4 that don't swap rows and columns: identity, rotate 180, mirror columns and mirror rows
+    //
+    template<int W, int H>
+    constexpr std::array<std::array<uint8_t, W * H>, W == H ? 8 : 4> makeCellMap()
+    {
+        std::array<std::array<uint8_t, W * H>, W == H ? 8 : 4> table = {};
+        for (int t = 0; t < (W == H ? 8 : 4); t++)
+        {
+            // rectangles number the 4 they keep in the same order as the square board's list
+            constexpr int kRectangleOps[4] = { 0, 2, 4, 5 };
+            int op = W == H ? t : kRectangleOps[t];
+            for (int row = 0; row < H; row++)
+            {
+                for (int column = 0; column < W; column++)
+                {
+                    int r = row, c = column;
+                    switch (op)
+                    {
+                        case 1: r = column;         c = W - 1 - row;    break;  // rotate 90
+                        case 2: r = H - 1 - row;    c = W - 1 - column; break;  // rotate 180
+                        case 3: r = W - 1 - column; c = row;            break;  // rotate 270
+                        case 4: c = W - 1 - column;                     break;  // mirror columns
+                        case 5: r = H - 1 - row;                        break;  // mirror rows
+                        case 6: r = column;         c = row;            break;  // main diagonal
+                        case 7: r = W - 1 - column; c = H - 1 - row;    break;  // anti diagonal
+                        default: break;                                         // identity
+                    }
+                    table[t][row * W + column] = (uint8_t)(r * W + c);
+                }
+            }
+        }
+        return table;
+    }
+}
+
+//
+// the rotations and reflections of a W x H board
+// positions that are the same up to symmetry have the same value, so the AI only needs
+// to search and store one of them: the canonical board, the image with the smallest key
+// (see SearchBoard, which keeps the key of every image up to date as moves are made)
+//
+template<int W, int H>
+struct BoardSymmetry
+{
+    static constexpr int kCells = W * H;
+    static constexpr int kTransforms = W == H ? 8 : 4;
+
+    // kCellMap[t][i] is where cell i ends up under transform t
+    // cells are numbered in state string order, i = row * W + column
+    // on 3x3 that's { 0..8 }, { 2, 5, 8, 1, 4, 7, 0, 3, 6 } (rotate 90), ...
+    static constexpr std::array<std::array<uint8_t, kCells>, kTransforms> kCellMap = MNKTables::makeCellMap<W, H>();
+
+    // the transform that undoes each transform (only the quarter turns aren't their own inverse)
+    static constexpr int inverse(int transform) { return kTransforms == 8 && (transform == 1 || transform == 3) ? 4 - transform : transform; }
+
+    template<class Board>
+    static constexpr Board apply(const Board &board, int transform)
+    {
+        Board mapped;
+        for (int player = 0; player < 2; player++)
+        {
+            for (auto cells = board.pieces[player]; cells; cells = MaskOps::withoutLowest(cells))
+            {
+                mapped.pieces[player] |= MaskOps::bit<typename Board::Mask>(kCellMap[transform][MaskOps::lowest(cells)]);
+            }
+        }
+        return mapped;
+    }
+
+    // move a cell index into, or back out of, the frame of a transform
+    static constexpr int mapCell(int cell, int transform) { return cell < 0 ? cell : kCellMap[transform][cell]; }
+    static constexpr int unmapCell(int cell, int transform) { return cell < 0 ? cell : kCellMap[inverse(transform)][cell]; }
+};
+
+// the 3x3 transforms keep the numbering they had before the board was generalized
+static_assert(BoardSymmetry<3, 3>::kCellMap[1] == std::array<uint8_t, 9> { 2, 5, 8, 1, 4, 7, 0, 3, 6 });
+static_assert(BoardSymmetry<3, 3>::kCellMap[7] == std::array<uint8_t, 9> { 8, 5, 2, 7, 4, 1, 6, 3, 0 });
@@ -16,6 +16,19 @@ Game::Game()
 	_gameOptions.rowY = 0;
 	_gameOptions.score = 0;
 	_gameOptions.AIDepthSearches = 0;
+	_gameOptions.AIMAXDepth = 0;
+	_gameOptions.AITimeBudgetMs = 0;
+	_gameOptions.AIUseSolvedTable = false;
+	_gameOptions.AIRunAsync = false;
+	_gameOptions.AIThreads = 1;
+	_gameOptions.AIUseMCTS = false;
+	_gameOptions.AIMCTSPlayouts = 0;
+	_gameOptions.AIUseThreatSearch = false;
+	_gameOptions.AIThreatDepth = 0;
+	_gameOptions.AIUseProofSearch = false;
+	_gameOptions.AIProofNodes = 0;
+	_gameOptions.AIUseOpeningBook = false;
+	_gameOptions.AIPonder = false;
 	_gameOptions.AIvsAI = false;
 	
 	_score = 0;
@@ -92,6 +105,16 @@ void Game::endTurn()
 	ClassGame::EndOfTurn();
 }
 
+void Game::resetTurns()
+{
+	if (_turns.empty()) return;
+	for (size_t i = 1; i < _turns.size(); i++) {
+		delete _turns[i];
+	}
+	_turns.resize(1);
+	_gameOptions.currentTurnNo = 0;
+}
+
 void Game::scanForMouse()
 {
     if (gameHasAI() && getCurrentPlayer()->isAIPlayer()) 
@@ -24,6 +24,18 @@ struct GameOptions
 	int score;
 	int AIDepthSearches;
 	int AIMAXDepth;
+	int AITimeBudgetMs;
+	bool AIUseSolvedTable;
+	bool AIRunAsync;
+	int AIThreads;
+	bool AIUseMCTS;
+	int AIMCTSPlayouts;
+	bool AIUseThreatSearch;
+	int AIThreatDepth;
+	bool AIUseProofSearch;
+	int AIProofNodes;
+	bool AIUseOpeningBook;
+	bool AIPonder;
 	bool AIvsAI;
 };
 
@@ -42,6 +54,8 @@ public:
 
 	// end the current game turn
 	void	endTurn();
+	// forget every turn after the start of the game and go back to turn 0
+	void	resetTurns();
 	
 	// Should return true if it is legal for the given bit to be moved from its current holder.
 	// Default implementation always returns true. 
@@ -0,0 +1,141 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include "MNKBoard.h"
+
+namespace MNKTables
+{
+    // how far apart neighbouring cells of a line are in the mask: across, down, diagonal, anti diagonal
+    template<int W>
+    constexpr std::array<int, 4> lineSteps() { return { 1, W, W + 1, W - 1 }; }
+
+    // kLineStarts[d] has a bit on every cell that a line of K cells in direction d can start from
+    template<class Mask, int W, int H, int K>
+    constexpr std::array<Mask, 4> makeLineStarts()
+    {
+        constexpr int kSteps[4][2] = { { 0, 1 }, { 1, 0 }, { 1, 1 }, { 1, -1 } };   // row, column steps
+        std::array<Mask, 4> starts = {};
+        for (int d = 0; d < 4; d++)
+        {
+            for (int row = 0; row < H; row++)
+            {
+                for (int column = 0; column < W; column++)
+                {
+                    int lastRow = row + kSteps[d][0] * (K - 1);
+                    int lastColumn = column + kSteps[d][1] * (K - 1);
+                    if (lastRow < 0 || lastRow >= H || lastColumn < 0 || lastColumn >= W) continue;
+                    starts[d] |= MaskOps::bit<Mask>(row * W + column);
+                }
+            }
+        }
+        return starts;
+    }
+}
+
+//
+// static evaluation of a position nobody has won yet, for when the search runs out of depth
+// every line of K cells that only one player has pieces in is still open to them, and is worth
+// more the more pieces they already have in it; lines with K - 1 pieces are threats to win next move
+// rather than walking the lines one at a time, each direction is scanned for every line at once:
+// the occupancy masks are shifted along the direction and added up bit-sliced, so bit c of the
+// count planes is how many pieces the line starting at cell c holds, 64 lines per machine word
+//
+template<int W, int H, int K>
+struct LineEvaluator
+{
+    using Board = MNKBoard<W, H, K>;
+    using Mask = typename Board::Mask;
+
+    // scores for positions that are won or lost no matter what, terminal wins score higher still
+    static constexpr int kForcedWinScore = 20000;
+    // the open line total is clamped to this, so it never reaches a forced win
+    static constexpr int kLimit = 10000;
+
+    // kLineWeights[n] is what an open line with n of the player's pieces is worth, 4 times per extra piece
+    static constexpr std::array<int, K + 1> makeLineWeights()
+    {
+        std::array<int, K + 1> weights = {};
+        for (int n = 1; n < K; n++) weights[n] = 1 << (2 * (n - 1));
+        return weights;
+    }
+    static constexpr std::array<int, K + 1> kLineWeights = makeLineWeights();
+
+    static constexpr std::array<int, 4> kSteps = MNKTables::lineSteps<W>();
+    static constexpr std::array<Mask, 4> kLineStarts = MNKTables::makeLineStarts<Mask, W, H, K>();
+    // enough bit planes to count to K
+    static constexpr int kPlanes = std::bit_width((unsigned)K);
+
+    // open line counts and threats for one player
+    struct Lines
+    {
+        int  weight = 0;        // kLineWeights summed over the player's open lines
+        Mask threats = {};      // empty cells that would complete one of the player's lines
+        Mask threatMakers = {}; // empty cells that would make a threat, only filled in when asked for
+    };
+
+    template<bool kFindThreatMakers = false>
+    static Lines scanLines(const Mask &mine, const Mask &theirs)
+    {
+        Lines lines;
+        Mask empty = Mask(~(mine | theirs) & Board::kFullMask);
+        for (int d = 0; d < 4; d++)
+        {
+            Mask starts = kLineStarts[d];
+            if (!starts) continue;
+
+            // lines the opponent has a piece in are dead, the rest get their pieces counted
+            Mask open = starts;
+            for (int i = 0; i < K; i++) open &= ~MaskOps::shiftDown(theirs, kSteps[d] * i);
+            Mask planes[kPlanes] = {};
+            for (int i = 0; i < K; i++)
+            {
+                Mask carry = MaskOps::shiftDown(mine, kSteps[d] * i) & open;
+                for (int p = 0; p < kPlanes && carry; p++)
+                {
+                    Mask next = planes[p] & carry;
+                    planes[p] ^= carry;
+                    carry = next;
+                }
+            }
+
+            for (int n = 1; n < K; n++)
+            {
+                Mask exactly = open;
+                for (int p = 0; p < kPlanes; p++) exactly &= (n >> p) & 1 ? planes[p] : Mask(~planes[p]);
+                if (!exactly) continue;
+                lines.weight += kLineWeights[n] * MaskOps::count(exactly);
+
+                // the one empty cell of a K - 1 line is a threat, walk the line starts back out over their cells
+                if (n == K - 1)
+                {
+                    for (int i = 0; i < K; i++) lines.threats |= MaskOps::shiftUp(exactly, kSteps[d] * i) & empty;
+                }
+                // and any empty cell of a K - 2 line turns it into one
+                if (kFindThreatMakers && n == K - 2)
+                {
+                    for (int i = 0; i < K; i++) lines.threatMakers |= MaskOps::shiftUp(exactly, kSteps[d] * i) & empty;
+                }
+            }
+        }
+        return lines;
+    }
+
+    //
+    // score for the side to move, positive is good for playerNumber
+    // a threat for the side to move wins on the next move, and two different threat cells for the
+    // opponent can't both be blocked, otherwise it's the balance of the two players' open lines
+    //
+    static int evaluate(const Board &board, int playerNumber)
+    {
+        Lines mine = scanLines(board.pieces[playerNumber], board.pieces[1 - playerNumber]);
+        if (mine.threats) return kForcedWinScore;
+        Lines theirs = scanLines(board.pieces[1 - playerNumber], board.pieces[playerNumber]);
+        if (MaskOps::count(theirs.threats) >= 2) return -kForcedWinScore;
+
+        int score = mine.weight - theirs.weight;
+        if (score > kLimit) return kLimit;
+        if (score < -kLimit) return -kLimit;
+        return score;
+    }
+};
@@ -2,6 +2,7 @@
 
 std::vector<LogEntry> Logger::_buffer;
 bool Logger::_scrollToBottom = false;
+std::mutex Logger::_mutex;
 
 Logger& Logger::GetInstance() 
 {
@@ -13,16 +14,24 @@ void Logger::ToFile()
 {
     std::string filename = "debug_log.txt";
     std::filesystem::path filePath = std::filesystem::current_path() / filename;
-    std::ofstream logFile(filePath);
-    for (const auto& entry : _buffer) logFile << entry.Message;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::ofstream logFile(filePath);
+        for (const auto& entry : _buffer) logFile << entry.Message;
+    }
     Logger::Info("Debug log saved to " + filePath.string());
 }
 
-void Logger::Clear() { _buffer.clear(); }
+void Logger::Clear() 
+{ 
+    std::lock_guard<std::mutex> lock(_mutex);
+    _buffer.clear(); 
+}
 
 void Logger::AddLog(const std::string& tag, const std::string& message, LogType type) 
 {
     LogEntry entry = { tag + " " + message + "\n", type };
+    std::lock_guard<std::mutex> lock(_mutex);
     _buffer.push_back(entry);
     _scrollToBottom = true;
 }
@@ -38,6 +47,7 @@ void Logger::Error(const std::string& message) { Logger::AddLog("[ERROR]", messa
 void Logger::Draw(const std::string& title) 
 {
     ImGui::Begin(title.c_str());
+    std::lock_guard<std::mutex> lock(_mutex);
 
     // Draw each message in its respective color
     for (const auto& entry : _buffer) 
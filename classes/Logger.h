@@ -4,6 +4,7 @@
 #include <vector>
 #include <fstream>
 #include <filesystem>
+#include <mutex>
 
 enum LogType { INFO, EVENT, WARNING, ERROR };
 
@@ -27,5 +28,6 @@ public:
 private:
 	static std::vector<LogEntry> _buffer;
 	static bool _scrollToBottom;
+	static std::mutex _mutex;	// the AI worker thread logs too
 	void AddLog(const std::string& tag, const std::string& message, LogType type);
 };
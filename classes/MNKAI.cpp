@@ -0,0 +1,428 @@
+#include "MNKAI.h"
+#include "Logger.h"
+
+// Search state that belongs to whichever thread is running negamax, so root moves can be searched in parallel
+// and the stats counters never bounce a cache line between threads
+// Only one board size searches on a thread at a time, so every instantiation shares them
+// (the killer table has a slot per ply of the biggest board there can be)
+static thread_local SearchStats t_searchStats;
+static thread_local int         t_rootPieces = 0;
+static constexpr std::array<int, 256> noKillerMoves()
+{
+    std::array<int, 256> moves = {};
+    moves.fill(-1);
+    return moves;
+}
+static thread_local std::array<int, 256> t_killerMoves = noKillerMoves();
+
+// Half the width of the window an iteration is searched with around the score it's expected to get
+// On 7x6x4 anything much narrower misses often enough that the searches again cost more than it saves
+static constexpr int kAspirationWindow = 64;
+
+static Logger &logger = Logger::GetInstance();
+
+// boards small enough for a ternary index get a slot for every state, bigger ones 2^20 slots (8 MB)
+template<int W, int H, int K>
+MNKAI<W, H, K>::MNKAI() :
+    MNKAI(std::make_shared<TranspositionTable>(Board::kCells <= 9 ? 15 : 20))
+{
+}
+
+template<int W, int H, int K>
+MNKAI<W, H, K>::MNKAI(std::shared_ptr<TranspositionTable> transpositionTable) :
+    _sharedTable(std::move(transpositionTable)),
+    _transpositionTable(*_sharedTable)
+{
+}
+
+//
+// Find all possible moves, returned as a mask of the empty cells (bit i is cell i)
+//
+template<int W, int H, int K>
+typename MNKAI<W, H, K>::Mask MNKAI<W, H, K>::generateMoves(const Board &board) const
+{
+    return board.emptyCells();
+}
+
+//
+// The winning side's player number, or Board::kNoWinner
+// Passing the last move played only tests the lines through that cell
+//
+template<int W, int H, int K>
+int MNKAI<W, H, K>::winner(const Board &board, int lastMove) const
+{
+    return board.winnerAfterMove(lastMove);
+}
+
+//
+// If there's a winner, return kWinScore if the current player has won, -kWinScore if the opponent won, and 0 if its a draw
+// A game that isn't over yet (the search ran out of depth) gets the LineEvaluator's guess, which always stays below a win
+//
+template<int W, int H, int K>
+int MNKAI<W, H, K>::evaluate(const Board &board, int playerNumber, int lastMove) const
+{
+    int winnerNumber = winner(board, lastMove);
+    if (winnerNumber != Board::kNoWinner) return winnerNumber == playerNumber ? kWinScore : -kWinScore;
+    if (board.isFull()) return 0;
+    return LineEvaluator<W, H, K>::evaluate(board, playerNumber);
+}
+
+//
+// Put the moves in search order: the hint move (if it's legal) first, then Board::kMoveOrder
+// (center, corners and edges on 3x3), good moves first means more alpha-beta cutoffs
+//
+template<int W, int H, int K>
+typename MNKAI<W, H, K>::Board::MoveList MNKAI<W, H, K>::orderMoves(Mask moves, int hintMove) const
+{
+    typename Board::MoveList orderedMoves;
+    if (hintMove >= 0 && MaskOps::test(moves, hintMove))
+    {
+        orderedMoves.push(hintMove);
+        moves &= ~MaskOps::bit<Mask>(hintMove);
+    }
+    for (int cell : Board::kMoveOrder)
+    {
+        if (MaskOps::test(moves, cell)) orderedMoves.push(cell);
+    }
+    return orderedMoves;
+}
+
+//
+// Find the most optimal move by evaluating all possible games stemming from that move
+// alpha and beta bound the window of scores that can still change the result above us,
+// as soon as a move scores at least beta the opponent will never allow this position so we stop
+//
+template<int W, int H, int K>
+int MNKAI<W, H, K>::negamax(Position &board, int depth, int alpha, int beta, int playerNumber, int lastMove)
+{
+    // Out of time or cancelled, the result will be thrown away so just unwind
+    if (_searchAborted.load(std::memory_order_relaxed)) return 0;
+    t_searchStats.nodes++;
+    if ((t_searchStats.nodes & 1023) == 0 && (_searchCancelled.load(std::memory_order_relaxed) ||
+                                              (_searchHasDeadline && std::chrono::steady_clock::now() >= _searchDeadline)))
+    {
+        _searchAborted = true;
+        return 0;
+    }
+
+    int ply = board.moveCount();
+    t_searchStats.maxDepth = std::max(t_searchStats.maxDepth, ply - t_rootPieces);
+    Mask moves = generateMoves(board.board());
+    // The game wasn't over before lastMove, so only the lines through it can hold a winner
+    bool terminal = !moves || winner(board.board(), lastMove) != Board::kNoWinner;
+    if (depth == 0 || terminal)
+    {
+        t_searchStats.leafEvaluations++;
+        if (terminal) t_searchStats.terminalHits++;
+        return evaluate(board.board(), playerNumber, lastMove);
+    }
+
+    // Searching past the last empty cell changes nothing, so clamp the depth to let more entries match
+    depth = std::min(depth, MaskOps::count(moves));
+    int hintMove = t_killerMoves[ply];
+
+    // Trust entries searched to exactly this depth, and deeper ones once their score is proven (a won or
+    // lost game, or a search that reached the last empty cell), since that's the game's real value
+    // A proven entry only helps if it was stored first, by another thread, an earlier turn or a ponder, so
+    // the same position can score differently from run to run: the real value one time, a guess the next
+    // Entries are stored in the canonical image's frame, so their moves get mapped back onto this board
+    CanonicalKey canonical = board.canonicalKey();
+    TTEntry entry;
+    bool found = _transpositionTable.probe(canonical.key, playerNumber, entry);
+    if (found) t_searchStats.tableHits++;
+    else t_searchStats.tableMisses++;
+    if (found)
+    {
+        hintMove = Position::Symmetry::unmapCell(entry.bestMove, canonical.transform);
+        bool proven = std::abs(entry.score) == kWinScore || entry.depth == MaskOps::count(moves);
+        if (entry.depth == depth || (entry.depth > depth && proven))
+        {
+            if (entry.bound == kBoundExact) return entry.score;
+            if (entry.bound == kBoundLower) alpha = std::max(alpha, (int)entry.score);
+            if (entry.bound == kBoundUpper) beta = std::min(beta, (int)entry.score);
+            if (alpha >= beta) return entry.score;
+        }
+    }
+
+    typename Board::MoveList orderedMoves = orderMoves(moves, hintMove);
+
+    int alphaOriginal = alpha;
+    int value = -kInfinity;
+    int bestMove = -1;
+    int nextPlayer = playerNumber == 0 ? 1 : 0;
+    for (int cell : orderedMoves)
+    {
+        board.makeMove(cell, playerNumber);
+        int score = -negamax(board, depth - 1, -beta, -alpha, nextPlayer, cell);
+        board.unmakeMove(cell, playerNumber);
+        if (_searchAborted.load(std::memory_order_relaxed)) return 0;
+        if (score > value)
+        {
+            value = score;
+            bestMove = cell;
+        }
+        alpha = std::max(alpha, value);
+        if (alpha >= beta)
+        {
+            t_searchStats.cutoffs++;
+            t_killerMoves[ply] = cell;
+            break;
+        }
+    }
+
+    TTBound bound = kBoundExact;
+    if (value <= alphaOriginal) bound = kBoundUpper;
+    else if (value >= beta) bound = kBoundLower;
+    _transpositionTable.store(canonical.key, playerNumber, depth, value, bound, Position::Symmetry::mapCell(bestMove, canonical.transform));
+    return value;
+}
+
+//
+// Search every root move to the given depth, returns the best move or -1 if the time ran out
+// Each root move gets the same alpha, beta window so its score doesn't depend on the others, which lets
+// the moves be split across threadCount threads and merged afterwards (up to the proven entries
+// negamax finds, or doesn't, in the table): the highest score wins, ties go to the move earliest
+// in the center, corners, edges order
+// If bestEvaluation ends up outside the window it's only a bound and the move may not be the best,
+// the caller has to search again with a wider window
+//
+template<int W, int H, int K>
+int MNKAI<W, H, K>::searchRoot(const Board &board, int playerNumber, int depth, int hintMove, int alpha, int beta, int threadCount,
+                               int &bestEvaluation)
+{
+    // Moves that lead to mirror images of an earlier move have the same value, so skip them
+    // This is done in the fixed move order so the same moves survive no matter what the hint is
+    typename Board::MoveList rootMoves;
+    uint64_t rootKeys[Board::kCells];
+    Position rootBoard(board);
+    for (int cell : orderMoves(generateMoves(board), -1))
+    {
+        rootBoard.makeMove(cell, playerNumber);
+        uint64_t childKey = rootBoard.canonicalKey().key;
+        rootBoard.unmakeMove(cell, playerNumber);
+        if (std::find(rootKeys, rootKeys + rootMoves.size(), childKey) != rootKeys + rootMoves.size()) continue;
+        rootKeys[rootMoves.size()] = childKey;
+        rootMoves.push(cell);
+    }
+    int rootCount = rootMoves.size();
+
+    // The hint only decides what gets searched first
+    int schedule[Board::kCells];
+    int scheduled = 0;
+    for (int i = 0; i < rootCount; i++) if (rootMoves[i] == hintMove) schedule[scheduled++] = i;
+    for (int i = 0; i < rootCount; i++) if (rootMoves[i] != hintMove) schedule[scheduled++] = i;
+
+    int evaluations[Board::kCells];
+    int lanes = std::max(1, std::min(threadCount, rootCount));
+
+    // each lane works through every lanes-th scheduled move and reports the nodes it visited
+    auto runLane = [&, this](int lane) -> SearchStats
+    {
+        auto laneStart = std::chrono::steady_clock::now();
+        t_searchStats = SearchStats();
+        t_rootPieces = board.pieceCount();
+        t_killerMoves = noKillerMoves();
+        // every lane plays its moves on its own copy of the board
+        Position laneBoard(board);
+        for (int i = lane; i < rootCount; i += lanes)
+        {
+            int cell = rootMoves[schedule[i]];
+            laneBoard.makeMove(cell, playerNumber);
+            evaluations[schedule[i]] = -negamax(laneBoard, depth - 1, -beta, -alpha, 1 - playerNumber, cell);
+            laneBoard.unmakeMove(cell, playerNumber);
+            if (_searchAborted.load(std::memory_order_relaxed)) break;
+        }
+        t_searchStats.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - laneStart).count();
+        return t_searchStats;
+    };
+
+    if (_threadStats.size() < (size_t)lanes) _threadStats.resize(lanes);
+    if (lanes == 1)
+    {
+        _threadStats[0].addPass(runLane(0));
+    }
+    else
+    {
+        if (!_threadPool) _threadPool = std::make_unique<ThreadPool>();
+        std::vector<std::future<SearchStats>> results;
+        for (int lane = 0; lane < lanes; lane++) results.push_back(_threadPool->submit([&runLane, lane]() { return runLane(lane); }));
+        for (int lane = 0; lane < lanes; lane++) _threadStats[lane].addPass(results[lane].get());
+    }
+    if (_searchAborted) return -1;
+
+    int bestMove = -1;
+    bestEvaluation = -kInfinity;
+    for (int i = 0; i < rootCount; i++)
+    {
+        if (evaluations[i] > bestEvaluation)
+        {
+            bestMove = rootMoves[i];
+            bestEvaluation = evaluations[i];
+        }
+    }
+
+    if (bestEvaluation <= alpha || bestEvaluation >= beta) return bestMove;
+    CanonicalKey canonical = rootBoard.canonicalKey();
+    _transpositionTable.store(canonical.key, playerNumber, depth, bestEvaluation, kBoundExact, Position::Symmetry::mapCell(bestMove, canonical.transform));
+    return bestMove;
+}
+
+//
+// Play bestMove then walk the transposition table's best moves to get the line the search expects
+// Stops at the first position that isn't stored, a move that can't be played or the end of the game
+//
+template<int W, int H, int K>
+void MNKAI<W, H, K>::extractPrincipalVariation(const Board &board, int playerNumber, int bestMove, int maxLength)
+{
+    _principalVariation = typename Board::MoveList();
+    Position position(board);
+    int player = playerNumber;
+    int cell = bestMove;
+    while (cell >= 0 && _principalVariation.size() < maxLength)
+    {
+        position.makeMove(cell, player);
+        _principalVariation.push(cell);
+        if (winner(position.board(), cell) != Board::kNoWinner) break;
+        player = 1 - player;
+
+        TTEntry entry;
+        CanonicalKey canonical = position.canonicalKey();
+        if (!_transpositionTable.probe(canonical.key, player, entry) || entry.bestMove < 0) break;
+        cell = Position::Symmetry::unmapCell(entry.bestMove, canonical.transform);
+        if (!MaskOps::test(position.board().emptyCells(), cell)) break;
+    }
+}
+
+//
+// If the human played the reply the last search expected, the rest of its line picks up from here:
+// fills in the score it expected and the move it expected next, false if the human went another way
+//
+template<int W, int H, int K>
+bool MNKAI<W, H, K>::continuePrincipalVariation(const Board &board, int playerNumber, int &score, int &move) const
+{
+    if (playerNumber != _principalPlayer || _principalVariation.size() < 3) return false;
+
+    Board expected = _principalRoot.withMove(_principalVariation[0], playerNumber).withMove(_principalVariation[1], 1 - playerNumber);
+    if (expected.pieces[0] != board.pieces[0] || expected.pieces[1] != board.pieces[1]) return false;
+    score = _principalScore;
+    move = _principalVariation[2];
+    return true;
+}
+
+//
+// Search for the best move for playerNumber from a snapshot of the board, returns the cell index or -1
+// Searches one ply deeper each iteration until maxDepth or timeBudgetMs runs out,
+// always keeping the move from the last iteration that finished
+// This never touches the game, so it's safe to run on the AI worker thread
+//
+template<int W, int H, int K>
+int MNKAI<W, H, K>::searchBestMove(const Board &board, int playerNumber, int maxDepth, int timeBudgetMs, int threadCount)
+{
+    Mask moves = generateMoves(board);
+    int fullDepth = MaskOps::count(moves);
+    if (maxDepth <= 0 || maxDepth > fullDepth) maxDepth = fullDepth;
+    int hintMove = -1;
+
+    auto searchStart = std::chrono::steady_clock::now();
+    _searchAborted = false;
+    _searchHasDeadline = timeBudgetMs > 0;
+    _searchDeadline = searchStart + std::chrono::milliseconds(timeBudgetMs);
+    _searchStats = SearchStats();
+    _threadStats.clear();
+
+    // 0 threads means all of them
+    if (threadCount <= 0)
+    {
+        if (!_threadPool) _threadPool = std::make_unique<ThreadPool>();
+        threadCount = (int)_threadPool->size();
+    }
+
+    // A position we've already searched (this turn or in an earlier game) tells us what to try first,
+    // and if it went to some depth already the deepening can start there
+    TTEntry entry;
+    int startDepth = 1;
+    CanonicalKey canonical = Position(board).canonicalKey();
+    if (_transpositionTable.probe(canonical.key, playerNumber, entry))
+    {
+        hintMove = Position::Symmetry::unmapCell(entry.bestMove, canonical.transform);
+        if (entry.bound == kBoundExact && entry.depth <= maxDepth) startDepth = std::max(1, (int)entry.depth);
+    }
+
+    // If the human played the reply the last search expected, its score is what the first iteration
+    // should come close to, after that each iteration is expected to come close to the one before
+    int expectedScore = 0;
+    int expectedMove = -1;
+    bool hasExpectedScore = continuePrincipalVariation(board, playerNumber, expectedScore, expectedMove);
+    if (hasExpectedScore)
+    {
+        _continuedLines++;
+        if (hintMove < 0) hintMove = expectedMove;
+        logger.Info("Continuing the principal variation with " + std::to_string(expectedMove) + ", expecting " + std::to_string(expectedScore));
+    }
+
+    // Each iteration's result is logged once the search is over, building the log strings
+    // in between would be the only heap allocations left inside a single-threaded search
+    int depthMoves[Board::kCells + 1];
+    int depthEvaluations[Board::kCells + 1];
+
+    int bestMove = -1;
+    int completedDepth = 0;
+    for (int depth = startDepth; depth <= maxDepth; depth++)
+    {
+        // A narrow window around the expected score cuts off more, but a forced win's score isn't
+        // anywhere near the one before it, and missing the window means searching again with all of it
+        int alpha = -kInfinity;
+        int beta = kInfinity;
+        if (hasExpectedScore && std::abs(expectedScore) < LineEvaluator<W, H, K>::kForcedWinScore)
+        {
+            alpha = expectedScore - kAspirationWindow;
+            beta = expectedScore + kAspirationWindow;
+        }
+        int evaluation = 0;
+        int move = searchRoot(board, playerNumber, depth, bestMove >= 0 ? bestMove : hintMove, alpha, beta, threadCount, evaluation);
+        if (!_searchAborted && (evaluation <= alpha || evaluation >= beta))
+        {
+            move = searchRoot(board, playerNumber, depth, move, -kInfinity, kInfinity, threadCount, evaluation);
+        }
+        if (_searchAborted) break;
+
+        expectedScore = evaluation;
+        hasExpectedScore = true;
+
+        bestMove = move;
+        completedDepth = depth;
+        depthMoves[depth] = move;
+        depthEvaluations[depth] = evaluation;
+    }
+    for (int depth = startDepth; depth <= completedDepth; depth++)
+    {
+        logger.Info("Depth " + std::to_string(depth) + " best move: " + std::to_string(depthMoves[depth]) + " Evaluation: " + std::to_string(depthEvaluations[depth]));
+    }
+
+    // Ran out of time before even depth 1 finished, the table's move beats the first empty cell
+    if (bestMove < 0 && hintMove >= 0 && MaskOps::test(moves, hintMove)) bestMove = hintMove;
+    if (bestMove < 0 && moves) bestMove = MaskOps::lowest(moves);
+
+    // A move picked without finishing an iteration has no line to carry over
+    _principalRoot = board;
+    _principalPlayer = playerNumber;
+    _principalScore = completedDepth > 0 ? depthEvaluations[completedDepth] : 0;
+    extractPrincipalVariation(board, playerNumber, completedDepth > 0 ? bestMove : -1, completedDepth);
+
+    for (const SearchStats &threadStats : _threadStats) _searchStats += threadStats;
+    _searchStats.completedDepth = completedDepth;
+    _searchStats.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - searchStart).count();
+
+    logger.Event("Chose best move: " + std::to_string(bestMove) + " at depth " + std::to_string(completedDepth)
+                 + " in " + std::to_string(_searchStats.elapsedMs) + " ms" + (_searchAborted ? " (stopped early)" : ""));
+    logger.Info("Searched " + std::to_string(_searchStats.nodes) + " nodes (" + std::to_string((uint64_t)_searchStats.nodesPerSecond())
+                + " per second), transposition table hits: " + std::to_string(_searchStats.tableHits)
+                + " misses: " + std::to_string(_searchStats.tableMisses));
+    _searchAborted = false;
+    return bestMove;
+}
+
+template class MNKAI<3, 3, 3>;
+template class MNKAI<4, 4, 4>;
+template class MNKAI<7, 6, 4>;
+template class MNKAI<15, 15, 5>;
@@ -0,0 +1,98 @@
+#pragma once
+#include "MNKBoard.h"
+#include "SearchBoard.h"
+#include "LineEvaluator.h"
+#include "TranspositionTable.h"
+#include "ThreadPool.h"
+#include "SearchStats.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+//
+// the m,n,k search: negamax with alpha-beta, a shared transposition table and iterative deepening
+// it only ever sees packed boards and player numbers, never the Game, its Players or the grid,
+// so it can run without a game (see tools/bench.cpp) and a win check is a few mask compares
+// every board size is its own instantiation, so the masks and tables are all compile-time constants
+//
+template<int W, int H, int K>
+class MNKAI
+{
+public:
+    using Board = MNKBoard<W, H, K>;
+    using Mask = typename Board::Mask;
+    using Position = SearchBoard<W, H, K>;
+
+    // a finished game scores kWinScore for the winner, anything the LineEvaluator says is smaller,
+    // and every score fits a transposition table entry
+    static constexpr int kWinScore = 30000;
+    static constexpr int kInfinity = kWinScore + 1;
+    static_assert(LineEvaluator<W, H, K>::kForcedWinScore < kWinScore);
+
+    MNKAI();
+    // a search that shares another one's table (see sharedTranspositionTable()), so each finds what the other stored
+    explicit MNKAI(std::shared_ptr<TranspositionTable> transpositionTable);
+
+    // the winning side's player number, or Board::kNoWinner
+    // lastMove is the cell the last piece went into, or -1 to check every line
+    int         winner(const Board &board, int lastMove = -1) const;
+    Mask        generateMoves(const Board &board) const;
+    int         evaluate(const Board &board, int playerNumber, int lastMove = -1) const;
+    // plays its moves on board and takes them back again, so board is unchanged when it returns
+    int         negamax(Position &board, int depth, int alpha, int beta, int playerNumber, int lastMove = -1);
+    int         searchBestMove(const Board &board, int playerNumber, int maxDepth, int timeBudgetMs, int threadCount);
+
+    // a running searchBestMove() gives up soon after this is set, it stays set until it's cleared
+    void        setCancelled(bool cancelled) { _searchCancelled = cancelled; }
+
+    // what the last search cost, in total and split by search thread
+    const SearchStats &searchStats() const { return _searchStats; }
+    const std::vector<SearchStats> &threadStats() const { return _threadStats; }
+    // kept for the whole session, so positions solved in earlier turns and games are free
+    const TranspositionTable &transpositionTable() const { return _transpositionTable; }
+    void        clearTranspositionTable() { _transpositionTable.clear(); }
+    std::shared_ptr<TranspositionTable> sharedTranspositionTable() const { return _sharedTable; }
+
+    // the line the last search expects both sides to play from the board it was given, its own move first,
+    // read back out of the transposition table, and that line's score for the side that searched
+    const typename Board::MoveList &principalVariation() const { return _principalVariation; }
+    int         principalScore() const { return _principalScore; }
+    // searches that started from the line the search before them expected, since this MNKAI was made
+    int         continuedLines() const { return _continuedLines; }
+
+private:
+    typename Board::MoveList orderMoves(Mask moves, int hintMove) const;
+    int         searchRoot(const Board &board, int playerNumber, int depth, int hintMove, int alpha, int beta, int threadCount,
+                           int &bestEvaluation);
+    void        extractPrincipalVariation(const Board &board, int playerNumber, int bestMove, int maxLength);
+    // true if board is the last search's root with the first two moves of its line played
+    bool        continuePrincipalVariation(const Board &board, int playerNumber, int &score, int &move) const;
+
+    SearchStats _searchStats;
+    std::vector<SearchStats> _threadStats;
+    std::unique_ptr<ThreadPool> _threadPool;    // started the first time the search goes parallel
+    std::shared_ptr<TranspositionTable> _sharedTable;
+    TranspositionTable &_transpositionTable;   // *_sharedTable, the search only ever goes through this
+    std::chrono::steady_clock::time_point _searchDeadline;
+    bool        _searchHasDeadline = false;
+    std::atomic<bool> _searchAborted { false };     // set once the time budget runs out, unwinds the search
+    std::atomic<bool> _searchCancelled { false };
+
+    // kept from one search to the next, so the AI's next turn starts from what this one expected
+    typename Board::MoveList _principalVariation;
+    int         _principalScore = 0;
+    Board       _principalRoot;
+    int         _principalPlayer = -1;
+    int         _continuedLines = 0;
+};
+
+// the board sizes the game offers, built once in MNKAI.cpp
+extern template class MNKAI<3, 3, 3>;
+extern template class MNKAI<4, 4, 4>;
+extern template class MNKAI<7, 6, 4>;
+extern template class MNKAI<15, 15, 5>;
+
+// the tic tac toe search
+using TicTacToeAI = MNKAI<3, 3, 3>;
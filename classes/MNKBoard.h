@@ -0,0 +1,417 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+//
+// kTernaryDigits[mask] is the base 3 number with a 1 digit wherever mask has a bit set,
+// so a board of up to 9 cells has a ternary index that's just two table lookups instead of a loop over the cells
+//
+constexpr std::array<uint16_t, 512> makeTernaryDigits()
+{
+    std::array<uint16_t, 512> table = {};
+    for (int mask = 0; mask < 512; mask++)
+    {
+        int value = 0;
+        int power = 1;
+        for (int cell = 0; cell < 9; cell++)
+        {
+            if (mask & (1 << cell)) value += power;
+            power *= 3;
+        }
+        table[mask] = (uint16_t)value;
+    }
+    return table;
+}
+
+inline constexpr std::array<uint16_t, 512> kTernaryDigits = makeTernaryDigits();
+
+//
+// occupancy mask for boards with more than 64 cells, a row of 64-bit words
+// it has the same operators as the integer masks, so the board code doesn't care which one it has
+//
+template<int Words>
+struct WideMask
+{
+    uint64_t words[Words] = {};
+
+    constexpr WideMask operator&(const WideMask &other) const { WideMask r; for (int i = 0; i < Words; i++) r.words[i] = words[i] & other.words[i]; return r; }
+    constexpr WideMask operator|(const WideMask &other) const { WideMask r; for (int i = 0; i < Words; i++) r.words[i] = words[i] | other.words[i]; return r; }
+    constexpr WideMask operator^(const WideMask &other) const { WideMask r; for (int i = 0; i < Words; i++) r.words[i] = words[i] ^ other.words[i]; return r; }
+    constexpr WideMask operator~() const { WideMask r; for (int i = 0; i < Words; i++) r.words[i] = ~words[i]; return r; }
+    constexpr WideMask &operator&=(const WideMask &other) { for (int i = 0; i < Words; i++) words[i] &= other.words[i]; return *this; }
+    constexpr WideMask &operator|=(const WideMask &other) { for (int i = 0; i < Words; i++) words[i] |= other.words[i]; return *this; }
+    constexpr WideMask &operator^=(const WideMask &other) { for (int i = 0; i < Words; i++) words[i] ^= other.words[i]; return *this; }
+    constexpr WideMask operator>>(int shift) const
+    {
+        WideMask r;
+        int wordShift = shift / 64, bitShift = shift % 64;
+        for (int i = 0; i + wordShift < Words; i++)
+        {
+            r.words[i] = words[i + wordShift] >> bitShift;
+            if (bitShift && i + wordShift + 1 < Words) r.words[i] |= words[i + wordShift + 1] << (64 - bitShift);
+        }
+        return r;
+    }
+    constexpr WideMask operator<<(int shift) const
+    {
+        WideMask r;
+        int wordShift = shift / 64, bitShift = shift % 64;
+        for (int i = Words - 1; i >= wordShift; i--)
+        {
+            r.words[i] = words[i - wordShift] << bitShift;
+            if (bitShift && i - wordShift - 1 >= 0) r.words[i] |= words[i - wordShift - 1] >> (64 - bitShift);
+        }
+        return r;
+    }
+    constexpr bool operator==(const WideMask &other) const { for (int i = 0; i < Words; i++) if (words[i] != other.words[i]) return false; return true; }
+    constexpr explicit operator bool() const { for (int i = 0; i < Words; i++) if (words[i]) return true; return false; }
+};
+
+// the smallest mask that holds one bit per cell
+template<int Cells>
+using MNKMask = std::conditional_t<Cells <= 16, uint16_t,
+                std::conditional_t<Cells <= 32, uint32_t,
+                std::conditional_t<Cells <= 64, uint64_t, WideMask<(Cells + 63) / 64>>>>;
+
+//
+// bit twiddling that works the same on the integer masks and WideMask
+//
+namespace MaskOps
+{
+    template<class Mask>
+    constexpr Mask bit(int cell)
+    {
+        if constexpr (std::is_integral_v<Mask>) return Mask(Mask(1) << cell);
+        else
+        {
+            Mask mask;
+            mask.words[cell / 64] = uint64_t(1) << (cell % 64);
+            return mask;
+        }
+    }
+
+    template<class Mask>
+    constexpr bool test(const Mask &mask, int cell)
+    {
+        if constexpr (std::is_integral_v<Mask>) return (mask >> cell) & 1;
+        else return (mask.words[cell / 64] >> (cell % 64)) & 1;
+    }
+
+    template<class Mask>
+    constexpr int count(const Mask &mask)
+    {
+        if constexpr (std::is_integral_v<Mask>) return std::popcount(mask);
+        else
+        {
+            int total = 0;
+            for (uint64_t word : mask.words) total += std::popcount(word);
+            return total;
+        }
+    }
+
+    // index of the lowest set bit, the mask can't be empty
+    template<class Mask>
+    constexpr int lowest(const Mask &mask)
+    {
+        if constexpr (std::is_integral_v<Mask>) return std::countr_zero(mask);
+        else
+        {
+            int word = 0;
+            while (!mask.words[word]) word++;
+            return word * 64 + std::countr_zero(mask.words[word]);
+        }
+    }
+
+    template<class Mask>
+    constexpr Mask withoutLowest(const Mask &mask)
+    {
+        if constexpr (std::is_integral_v<Mask>) return Mask(mask & (mask - 1));
+        else
+        {
+            Mask next = mask;
+            int word = 0;
+            while (!next.words[word]) word++;
+            next.words[word] &= next.words[word] - 1;
+            return next;
+        }
+    }
+
+    // shifts that drop whatever falls off either end, even when shifting by the whole width
+    template<class Mask>
+    constexpr Mask shiftDown(const Mask &mask, int shift)
+    {
+        if constexpr (std::is_integral_v<Mask>) return shift >= 8 * (int)sizeof(Mask) ? Mask(0) : Mask(mask >> shift);
+        else return mask >> shift;
+    }
+
+    template<class Mask>
+    constexpr Mask shiftUp(const Mask &mask, int shift)
+    {
+        if constexpr (std::is_integral_v<Mask>) return shift >= 8 * (int)sizeof(Mask) ? Mask(0) : Mask(mask << shift);
+        else return mask << shift;
+    }
+
+    template<class Mask>
+    constexpr Mask firstCells(int cells)
+    {
+        Mask mask = {};
+        for (int cell = 0; cell < cells; cell++) mask |= bit<Mask>(cell);
+        return mask;
+    }
+}
+
+//
+// the tables every m,n,k board is built from, worked out by the compiler for each board size
+// cells are numbered in state string order, cell = row * width + column
+//
+namespace MNKTables
+{
+    // lines through a single cell, at most K in each of the 4 directions
+    template<int MaxLines>
+    struct CellLines
+    {
+        int      count = 0;
+        uint16_t lines[MaxLines] = {};
+    };
+
+    constexpr int lineCount(int w, int h, int k)
+    {
+        int across = w >= k ? h * (w - k + 1) : 0;
+        int down = h >= k ? w * (h - k + 1) : 0;
+        int diagonal = w >= k && h >= k ? 2 * (w - k + 1) * (h - k + 1) : 0;
+        return across + down + diagonal;
+    }
+
+    // every run of K cells across, down and along both diagonals, in that order
+    template<class Mask, int W, int H, int K>
+    constexpr std::array<Mask, lineCount(W, H, K)> makeWinMasks()
+    {
+        std::array<Mask, lineCount(W, H, K)> masks = {};
+        constexpr int kSteps[4][2] = { { 0, 1 }, { 1, 0 }, { 1, 1 }, { 1, -1 } };   // row, column steps
+        int line = 0;
+        for (const auto &step : kSteps)
+        {
+            for (int row = 0; row < H; row++)
+            {
+                for (int column = 0; column < W; column++)
+                {
+                    int lastRow = row + step[0] * (K - 1);
+                    int lastColumn = column + step[1] * (K - 1);
+                    if (lastRow < 0 || lastRow >= H || lastColumn < 0 || lastColumn >= W) continue;
+                    Mask mask = {};
+                    for (int i = 0; i < K; i++) mask |= MaskOps::bit<Mask>((row + step[0] * i) * W + column + step[1] * i);
+                    masks[line++] = mask;
+                }
+            }
+        }
+        return masks;
+    }
+
+    template<class Mask, int W, int H, int K>
+    constexpr std::array<CellLines<4 * K>, W * H> makeCellLines()
+    {
+        constexpr std::array<Mask, lineCount(W, H, K)> masks = makeWinMasks<Mask, W, H, K>();
+        std::array<CellLines<4 * K>, W * H> table = {};
+        for (int line = 0; line < lineCount(W, H, K); line++)
+        {
+            for (int cell = 0; cell < W * H; cell++)
+            {
+                if (MaskOps::test(masks[line], cell)) table[cell].lines[table[cell].count++] = (uint16_t)line;
+            }
+        }
+        return table;
+    }
+
+    //
+    // the order moves are tried in: cells on the most lines first, then the ones nearest the
+    // center, then by index, on 3x3 that's center, corners, edges
+    //
+    template<int W, int H, int K>
+    constexpr std::array<uint8_t, W * H> makeMoveOrder()
+    {
+        constexpr auto cellLines = makeCellLines<MNKMask<W * H>, W, H, K>();
+        auto before = [&](int a, int b)
+        {
+            if (cellLines[a].count != cellLines[b].count) return cellLines[a].count > cellLines[b].count;
+            // doubled distances from the center so even sizes stay in integers
+            auto distance = [](int cell)
+            {
+                int dx = 2 * (cell % W) - (W - 1);
+                int dy = 2 * (cell / W) - (H - 1);
+                return dx * dx + dy * dy;
+            };
+            if (distance(a) != distance(b)) return distance(a) < distance(b);
+            return a < b;
+        };
+
+        std::array<uint8_t, W * H> order = {};
+        for (int cell = 0; cell < W * H; cell++)
+        {
+            int i = cell;
+            while (i > 0 && before(cell, order[i - 1]))
+            {
+                order[i] = order[i - 1];
+                i--;
+            }
+            order[i] = (uint8_t)cell;
+        }
+        return order;
+    }
+
+    constexpr int powerOfThree(int exponent)
+    {
+        int value = 1;
+        for (int i = 0; i < exponent; i++) value *= 3;
+        return value;
+    }
+}
+
+//
+// packed m,n,k game position: a W x H board where K in a row wins, used by the AI search
+// each player gets an occupancy mask, bit i is cell i of the state string
+// (so it converts to and from stateString() without any reordering)
+// tic tac toe is MNKBoard<3, 3, 3> (see TicTacToeBoard.h)
+//
+template<int W, int H, int K>
+struct MNKBoard
+{
+    static_assert(W > 0 && H > 0 && K > 0 && (K <= W || K <= H), "nobody can ever get K in a row on this board");
+    static_assert(W * H <= 255, "cells have to fit in a byte");
+
+    using Mask = MNKMask<W * H>;
+
+    static constexpr int  kWidth     = W;
+    static constexpr int  kHeight    = H;
+    static constexpr int  kWinLength = K;
+    static constexpr int  kCells     = W * H;
+    // only boards small enough for a perfect ternary index have a state count
+    static constexpr int  kStates    = kCells <= 9 ? MNKTables::powerOfThree(kCells) : 0;
+    static constexpr int  kLines     = MNKTables::lineCount(W, H, K);
+    static constexpr int  kNoWinner  = -1;
+    static constexpr Mask kFullMask  = MaskOps::firstCells<Mask>(kCells);
+
+    // The winning combinations, one mask per run of K cells
+    static constexpr std::array<Mask, kLines> kWinMasks = MNKTables::makeWinMasks<Mask, W, H, K>();
+
+    // kCellLines[cell] lists the kWinMasks that go through the cell, a move can only complete one of those
+    static constexpr std::array<MNKTables::CellLines<4 * K>, kCells> kCellLines = MNKTables::makeCellLines<Mask, W, H, K>();
+
+    // Search order for move generation, cells on more lines first (center, then corners, then edges on 3x3)
+    static constexpr std::array<uint8_t, kCells> kMoveOrder = MNKTables::makeMoveOrder<W, H, K>();
+
+    //
+    // fixed-capacity list of cell indices, it lives on the caller's stack so ordering moves never allocates
+    //
+    struct MoveList
+    {
+        uint8_t cells[kCells];
+        int     count = 0;
+
+        constexpr void push(int cell) { cells[count++] = (uint8_t)cell; }
+        constexpr int  size() const { return count; }
+        constexpr int  operator[](int index) const { return cells[index]; }
+        constexpr const uint8_t *begin() const { return cells; }
+        constexpr const uint8_t *end() const { return cells + count; }
+    };
+
+    Mask pieces[2] = {};
+
+    constexpr Mask occupied() const { return pieces[0] | pieces[1]; }
+    constexpr Mask emptyCells() const { return Mask(~occupied() & kFullMask); }
+    constexpr bool isFull() const { return occupied() == kFullMask; }
+    constexpr int  pieceCount() const { return MaskOps::count(occupied()); }
+
+    // 0 for the first player's piece, 1 for the second's, -1 if the cell is empty
+    constexpr int ownerAt(int cell) const
+    {
+        if (MaskOps::test(pieces[0], cell)) return 0;
+        if (MaskOps::test(pieces[1], cell)) return 1;
+        return -1;
+    }
+
+    // perfect index of the board in [0, kStates), digit i is the state string character at cell i
+    constexpr int ternaryIndex() const requires (kCells <= 9)
+    {
+        return kTernaryDigits[pieces[0]] + 2 * kTernaryDigits[pieces[1]];
+    }
+
+    static constexpr MNKBoard fromTernaryIndex(int index) requires (kCells <= 9)
+    {
+        MNKBoard board;
+        for (int cell = 0; cell < kCells; cell++, index /= 3)
+        {
+            int digit = index % 3;
+            if (digit) board.pieces[digit - 1] |= MaskOps::bit<Mask>(cell);
+        }
+        return board;
+    }
+
+    // returns a copy of the board with the player's piece added at cell
+    constexpr MNKBoard withMove(int cell, int playerNumber) const
+    {
+        MNKBoard next = *this;
+        next.pieces[playerNumber] |= MaskOps::bit<Mask>(cell);
+        return next;
+    }
+
+    // returns the winning player's number, or kNoWinner if nobody has K in a row
+    constexpr int winner() const
+    {
+        for (const Mask &mask : kWinMasks)
+        {
+            if ((pieces[0] & mask) == mask) return 0;
+            if ((pieces[1] & mask) == mask) return 1;
+        }
+        return kNoWinner;
+    }
+
+    // true if the player has a line through cell, only the lines in kCellLines[cell] are tested
+    constexpr bool winsThrough(int cell, int playerNumber) const
+    {
+        const auto &lines = kCellLines[cell];
+        for (int i = 0; i < lines.count; i++)
+        {
+            const Mask &mask = kWinMasks[lines.lines[i]];
+            if ((pieces[playerNumber] & mask) == mask) return true;
+        }
+        return false;
+    }
+
+    // winner() for a board where lastMove was the last piece placed, so only its lines need checking
+    // a negative lastMove (nothing known about the last move) falls back to the full scan
+    constexpr int winnerAfterMove(int lastMove) const
+    {
+        if (lastMove < 0) return winner();
+        int playerNumber = ownerAt(lastMove);
+        if (playerNumber < 0) return kNoWinner;
+        return winsThrough(lastMove, playerNumber) ? playerNumber : kNoWinner;
+    }
+
+    //
+    // state string adapters, these are for the UI and Turn history only, never the search
+    //
+    static MNKBoard fromStateString(const std::string &s)
+    {
+        MNKBoard board;
+        for (int i = 0; i < kCells && i < (int)s.length(); i++)
+        {
+            if (s[i] == '1') board.pieces[0] |= MaskOps::bit<Mask>(i);
+            else if (s[i] == '2') board.pieces[1] |= MaskOps::bit<Mask>(i);
+        }
+        return board;
+    }
+
+    std::string toStateString() const
+    {
+        std::string s(kCells, '0');
+        for (int i = 0; i < kCells; i++)
+        {
+            int owner = ownerAt(i);
+            if (owner >= 0) s[i] = (char)('1' + owner);
+        }
+        return s;
+    }
+};
@@ -0,0 +1,358 @@
+#include "MNKMCTS.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+static Logger &logger = Logger::GetInstance();
+
+// the usual UCT exploration constant, sqrt(2)
+static constexpr float kExploration = 1.41421356f;
+
+template<int W, int H, int K>
+MNKMCTS<W, H, K>::MNKMCTS(size_t arenaNodes) :
+    _arenaNodes(arenaNodes)
+{
+}
+
+//
+// xorshift64*, playouts need lots of cheap random numbers and none of them need to be good
+// each worker keeps its own state so they don't fight over a cache line
+//
+template<int W, int H, int K>
+uint64_t MNKMCTS<W, H, K>::nextRandom(uint64_t &randomState)
+{
+    randomState ^= randomState >> 12;
+    randomState ^= randomState << 25;
+    randomState ^= randomState >> 27;
+    return randomState * 0x2545F4914F6CDD1Dull;
+}
+
+//
+// Give the node a child for every empty cell, all in one block of the arena and in Board::kMoveOrder,
+// so the first unvisited child tried is the one nearest the center
+// Returns the first child, kExpanding if another thread is adding them right now, or kNone when
+// the arena is full; in both of those the node stays a leaf and just gets played out
+//
+template<int W, int H, int K>
+int32_t MNKMCTS<W, H, K>::expand(int32_t index, const Board &board, SearchStats &stats)
+{
+    NodeArena<Node> &tree = *_tree;
+    Node &node = tree[index];
+    int32_t expected = NodeArena<Node>::kNone;
+    if (!node.firstChild.compare_exchange_strong(expected, kExpanding, std::memory_order_acquire)) return expected;
+
+    typename Board::Mask moves = board.emptyCells();
+    int count = MaskOps::count(moves);
+    int32_t first = tree.allocate(count);
+    if (first == NodeArena<Node>::kNone)
+    {
+        node.firstChild.store(NodeArena<Node>::kNone, std::memory_order_relaxed);
+        return NodeArena<Node>::kNone;
+    }
+
+    int child = 0;
+    for (int cell : Board::kMoveOrder)
+    {
+        if (MaskOps::test(moves, cell)) tree[first + child++].move = (uint8_t)cell;
+    }
+    node.childCount = (uint16_t)count;
+    node.firstChild.store(first, std::memory_order_release);
+    stats.nodes += count;
+    return first;
+}
+
+//
+// the child with the best upper confidence bound, an unvisited child always goes first
+// visits include the virtual losses of playouts still running below a child
+//
+template<int W, int H, int K>
+int32_t MNKMCTS<W, H, K>::selectChild(int32_t index, int32_t firstChild) const
+{
+    const NodeArena<Node> &tree = *_tree;
+    const Node &parent = tree[index];
+    int32_t best = firstChild;
+    float bestScore = -1.0f;
+    float logVisits = 0.0f;
+    for (int i = 0; i < parent.childCount; i++)
+    {
+        const Node &child = tree[firstChild + i];
+        uint32_t visits = child.visits.load(std::memory_order_relaxed);
+        if (visits == 0) return firstChild + i;
+        if (i == 0) logVisits = std::log((float)parent.visits.load(std::memory_order_relaxed));
+        float wins = 0.5f * child.points.load(std::memory_order_relaxed);
+        float score = wins / visits + kExploration * std::sqrt(logVisits / visits);
+        if (score > bestScore)
+        {
+            bestScore = score;
+            best = firstChild + i;
+        }
+    }
+    return best;
+}
+
+//
+// play random moves until someone gets K in a row, returns the winner or -1 for a draw
+// the empty cells go in a list that shrinks as they fill, so every move is one random number
+//
+template<int W, int H, int K>
+int MNKMCTS<W, H, K>::playout(Board board, int playerNumber, uint64_t &randomState)
+{
+    typename Board::MoveList cells;
+    for (auto moves = board.emptyCells(); moves; moves = MaskOps::withoutLowest(moves)) cells.push(MaskOps::lowest(moves));
+
+    int count = cells.size();
+    while (count > 0)
+    {
+        int pick = (int)(nextRandom(randomState) % (uint64_t)count);
+        int cell = cells[pick];
+        cells.cells[pick] = cells.cells[--count];
+        board.pieces[playerNumber] |= MaskOps::bit<typename Board::Mask>(cell);
+        if (board.winsThrough(cell, playerNumber)) return playerNumber;
+        playerNumber = 1 - playerNumber;
+    }
+    return -1;
+}
+
+//
+// copy the subtree under index into the spare arena, breadth first so the copied nodes themselves
+// are the queue of nodes whose children still need copying, then make the spare arena the tree
+// children that don't fit any more are dropped, their parent just gets expanded again later
+//
+template<int W, int H, int K>
+int32_t MNKMCTS<W, H, K>::copySubtree(int32_t index)
+{
+    NodeArena<Node> &from = *_tree;
+    NodeArena<Node> &to = *_spareTree;
+    to.reset();
+    int32_t root = to.allocate(1);
+    to[root] = from[index];
+    for (size_t i = (size_t)root; i < to.used(); i++)
+    {
+        if (!to[i].childCount) continue;
+        int32_t first = to.allocate(to[i].childCount);
+        if (first == NodeArena<Node>::kNone)
+        {
+            to[i].firstChild = NodeArena<Node>::kNone;
+            to[i].childCount = 0;
+            continue;
+        }
+        for (int child = 0; child < to[i].childCount; child++) to[first + child] = from[to[i].firstChild + child];
+        to[i].firstChild = first;
+    }
+    std::swap(_tree, _spareTree);
+    return root;
+}
+
+//
+// if board follows on from the last search's root, walk the tree down the moves played since
+// and keep that subtree, so the playouts already spent on this position aren't thrown away
+//
+template<int W, int H, int K>
+bool MNKMCTS<W, H, K>::reuseTree(const Board &board, int playerNumber)
+{
+    if (_root == NodeArena<Node>::kNone) return false;
+    // every piece on the old root board has to still be there
+    for (int player = 0; player < 2; player++)
+    {
+        if ((_rootBoard.pieces[player] & ~board.pieces[player]) != typename Board::Mask()) return false;
+    }
+
+    const NodeArena<Node> &tree = *_tree;
+    int32_t index = _root;
+    Board walked = _rootBoard;
+    int toMove = _rootPlayer;
+    while (walked.pieceCount() < board.pieceCount())
+    {
+        const Node &node = tree[index];
+        int32_t next = NodeArena<Node>::kNone;
+        for (int i = 0; i < node.childCount && next == NodeArena<Node>::kNone; i++)
+        {
+            int cell = tree[node.firstChild + i].move;
+            if (board.ownerAt(cell) == toMove) next = node.firstChild + i;
+        }
+        if (next == NodeArena<Node>::kNone) return false;
+        walked = walked.withMove(tree[next].move, toMove);
+        toMove = 1 - toMove;
+        index = next;
+    }
+    if (!(walked.occupied() == board.occupied()) || walked.pieces[0] != board.pieces[0] || toMove != playerNumber) return false;
+
+    _root = copySubtree(index);
+    return true;
+}
+
+//
+// one search thread: claim a playout from the budget, walk down, play out, count the result back up
+// and repeat until the budget, the deadline or a cancel stops it; returns what this thread did
+//
+template<int W, int H, int K>
+SearchStats MNKMCTS<W, H, K>::runWorker(const Board &board, int playerNumber, uint64_t playoutBudget, bool hasDeadline,
+                                        std::chrono::steady_clock::time_point deadline, uint64_t randomSeed)
+{
+    auto workerStart = std::chrono::steady_clock::now();
+    SearchStats stats;
+    uint64_t randomState = randomSeed;
+    NodeArena<Node> &tree = *_tree;
+    int32_t path[Board::kCells + 1];
+    while (_playoutsClaimed.fetch_add(1, std::memory_order_relaxed) < playoutBudget)
+    {
+        if ((stats.playouts & 63) == 0 && (_searchCancelled.load(std::memory_order_relaxed) ||
+                                           (hasDeadline && std::chrono::steady_clock::now() >= deadline))) break;
+
+        // Walk down by upper confidence bound until a node that hasn't been played out from yet,
+        // counting the visit to each node as we go so the other threads steer around this path
+        int32_t index = _root;
+        Board walked = board;
+        int toMove = playerNumber;
+        int depth = 0;
+        path[0] = _root;
+        tree[_root].visits.fetch_add(1, std::memory_order_relaxed);
+        while (tree[index].result.load(std::memory_order_relaxed) == kOpen || index == _root)
+        {
+            Node &node = tree[index];
+            int32_t firstChild = node.firstChild.load(std::memory_order_acquire);
+            if (firstChild < 0)
+            {
+                // the first playout through a node starts from it, the second one adds its children
+                if (firstChild == kExpanding || (index != _root && node.visits.load(std::memory_order_relaxed) <= 1)) break;
+                firstChild = expand(index, walked, stats);
+                if (firstChild < 0) break;
+            }
+            index = selectChild(index, firstChild);
+            Node &child = tree[index];
+            child.visits.fetch_add(1, std::memory_order_relaxed);
+            walked.pieces[toMove] |= MaskOps::bit<typename Board::Mask>(child.move);
+            if (child.result.load(std::memory_order_relaxed) == kUnknown)
+            {
+                uint8_t result = walked.winsThrough(child.move, toMove) ? kWon : walked.isFull() ? kDrawn : kOpen;
+                child.result.store(result, std::memory_order_relaxed);
+            }
+            toMove = 1 - toMove;
+            path[++depth] = index;
+        }
+        stats.maxDepth = std::max(stats.maxDepth, depth);
+
+        int winner;
+        uint8_t result = depth ? tree[index].result.load(std::memory_order_relaxed) : (uint8_t)kOpen;
+        if (result == kWon)
+        {
+            winner = 1 - toMove;
+            stats.terminalHits++;
+        }
+        else if (result == kDrawn)
+        {
+            winner = -1;
+            stats.terminalHits++;
+        }
+        else
+        {
+            winner = playout(walked, toMove, randomState);
+            stats.leafEvaluations++;
+        }
+
+        // The visits were counted on the way down, now the result goes to whoever made the move
+        // into each node on the path; the root's mover is the opponent
+        for (int d = 0; d <= depth; d++)
+        {
+            int mover = d % 2 ? playerNumber : 1 - playerNumber;
+            uint32_t points = winner < 0 ? 1 : winner == mover ? 2 : 0;
+            if (points) tree[path[d]].points.fetch_add(points, std::memory_order_relaxed);
+        }
+        stats.playouts++;
+    }
+    stats.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - workerStart).count();
+    return stats;
+}
+
+//
+// Search for the best move for playerNumber from a snapshot of the board, returns the cell index or -1
+// This never touches the game, so it's safe to run on the AI worker thread
+//
+template<int W, int H, int K>
+int MNKMCTS<W, H, K>::searchBestMove(const Board &board, int playerNumber, int playoutBudget, int timeBudgetMs, int threadCount)
+{
+    auto searchStart = std::chrono::steady_clock::now();
+    auto deadline = searchStart + std::chrono::milliseconds(timeBudgetMs);
+    _searchStats = SearchStats();
+    if (!board.emptyCells()) return -1;
+    if (playoutBudget <= 0 && timeBudgetMs <= 0) playoutBudget = kDefaultPlayouts;
+
+    if (!_tree)
+    {
+        _tree = std::make_unique<NodeArena<Node>>(_arenaNodes);
+        _spareTree = std::make_unique<NodeArena<Node>>(_arenaNodes);
+    }
+    bool reused = reuseTree(board, playerNumber);
+    size_t reusedNodes = reused ? _tree->used() : 0;
+    if (!reused)
+    {
+        _tree->reset();
+        _root = _tree->allocate(1);
+    }
+    _rootBoard = board;
+    _rootPlayer = playerNumber;
+
+    // 0 threads means all of them
+    if (threadCount <= 0)
+    {
+        if (!_threadPool) _threadPool = std::make_unique<ThreadPool>();
+        threadCount = (int)_threadPool->size();
+    }
+    bool hasDeadline = timeBudgetMs > 0;
+    uint64_t budget = playoutBudget > 0 ? (uint64_t)playoutBudget : UINT64_MAX;
+    _playoutsClaimed = 0;
+    _randomSeed = nextRandom(_randomSeed);
+
+    _threadStats.assign(threadCount, SearchStats());
+    if (threadCount == 1)
+    {
+        _threadStats[0] = runWorker(board, playerNumber, budget, hasDeadline, deadline, _randomSeed);
+    }
+    else
+    {
+        if (!_threadPool) _threadPool = std::make_unique<ThreadPool>();
+        std::vector<std::future<SearchStats>> results;
+        for (int thread = 0; thread < threadCount; thread++)
+        {
+            // every worker gets its own random sequence, xorshift state must never be 0
+            uint64_t seed = _randomSeed ^ (0x9E3779B97F4A7C15ull * (thread + 1));
+            results.push_back(_threadPool->submit([=, this]() {
+                return runWorker(board, playerNumber, budget, hasDeadline, deadline, seed ? seed : 1);
+            }));
+        }
+        for (int thread = 0; thread < threadCount; thread++) _threadStats[thread] = results[thread].get();
+    }
+    for (const SearchStats &threadStats : _threadStats) _searchStats += threadStats;
+
+    NodeArena<Node> &tree = *_tree;
+    // The most visited move is the one the search trusts most
+    const Node &root = tree[_root];
+    int32_t firstChild = root.firstChild.load(std::memory_order_relaxed);
+    int bestMove = -1;
+    uint32_t bestVisits = 0;
+    for (int i = 0; firstChild >= 0 && i < root.childCount; i++)
+    {
+        const Node &child = tree[firstChild + i];
+        uint32_t visits = child.visits.load(std::memory_order_relaxed);
+        if (bestMove < 0 || visits > bestVisits)
+        {
+            bestMove = child.move;
+            bestVisits = visits;
+        }
+    }
+    if (bestMove < 0) bestMove = MaskOps::lowest(board.emptyCells());
+
+    _searchStats.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - searchStart).count();
+
+    logger.Event("MCTS chose best move: " + std::to_string(bestMove) + " after " + std::to_string(_searchStats.playouts) + " playouts on "
+                 + std::to_string(threadCount) + " threads in " + std::to_string(_searchStats.elapsedMs) + " ms");
+    logger.Info("Tree has " + std::to_string(tree.used()) + " nodes (" + std::to_string(reusedNodes) + " kept from the last move), "
+                + std::to_string((uint64_t)_searchStats.playoutsPerSecond()) + " playouts per second");
+    return bestMove;
+}
+
+template class MNKMCTS<3, 3, 3>;
+template class MNKMCTS<4, 4, 4>;
+template class MNKMCTS<7, 6, 4>;
+template class MNKMCTS<15, 15, 5>;
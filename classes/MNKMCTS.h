@@ -0,0 +1,112 @@
+#pragma once
+#include "MNKBoard.h"
+#include "NodeArena.h"
+#include "SearchStats.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+//
+// Monte Carlo tree search (UCT) for the boards that are too big for negamax to see the end of
+// each playout walks down the tree picking children by their upper confidence bound, adds the
+// children of the leaf it reaches, plays the rest of the game out at random and counts the result
+// back up the path; the move played is the root child that was visited most
+// the tree lives in a NodeArena, after the opponent replies the subtree under the position we're
+// in now is copied into the spare arena and the search carries on from there
+// with more than one thread they all walk the same tree: node counters are atomics rather than
+// locked, and a node's visit is counted on the way down before its result is known (a virtual
+// loss), so the threads behind it see it as worse for now and spread out over other paths
+//
+template<int W, int H, int K>
+class MNKMCTS
+{
+public:
+    using Board = MNKBoard<W, H, K>;
+
+    // arenaNodes is the size of each of the two arenas, taken the first time the engine searches
+    explicit MNKMCTS(size_t arenaNodes = size_t(1) << 20);
+
+    // runs playouts until playoutBudget of them are done or timeBudgetMs runs out (0 turns either off,
+    // with both off it does kDefaultPlayouts), returns the cell index or -1 if there's no move
+    // threadCount threads share the budget, 0 means one per hardware thread
+    int         searchBestMove(const Board &board, int playerNumber, int playoutBudget, int timeBudgetMs, int threadCount = 1);
+
+    // forget the tree, so the next search starts from scratch instead of reusing a subtree
+    void        clearTree() { _root = NodeArena<Node>::kNone; }
+
+    // a running searchBestMove() gives up soon after this is set, it stays set until it's cleared
+    void        setCancelled(bool cancelled) { _searchCancelled = cancelled; }
+
+    const SearchStats &searchStats() const { return _searchStats; }
+    const std::vector<SearchStats> &threadStats() const { return _threadStats; }
+    // bytes held by the two arenas, 0 until the first search
+    size_t      arenaBytes() const { return _tree ? _tree->bytes() + _spareTree->bytes() : 0; }
+
+    static constexpr int kDefaultPlayouts = 10000;
+
+private:
+    enum : uint8_t
+    {
+        kUnknown,                   // nobody has reached the node yet
+        kOpen,                      // the game goes on
+        kWon,                       // the move into this node won
+        kDrawn                      // the move into this node filled the board
+    };
+
+    // firstChild while one thread is adding the children, the others play out from the node meanwhile
+    static constexpr int32_t kExpanding = -2;
+
+    struct Node
+    {
+        std::atomic<uint32_t> visits { 0 };     // counted on the way down, so it includes playouts still running
+        std::atomic<uint32_t> points { 0 };     // 2 per win for the player who moved into this node, 1 per draw
+        std::atomic<int32_t>  firstChild { NodeArena<Node>::kNone };
+        uint16_t childCount = 0;                // written before firstChild is published
+        uint8_t  move = 0;                      // cell played to get here from the parent
+        std::atomic<uint8_t>  result { kUnknown };  // every thread that finds it unknown works out the same answer
+
+        Node() = default;
+        // the arenas reset and copy nodes while no search is running
+        Node &operator=(const Node &other)
+        {
+            visits.store(other.visits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            points.store(other.points.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            firstChild.store(other.firstChild.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            childCount = other.childCount;
+            move = other.move;
+            result.store(other.result.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            return *this;
+        }
+    };
+
+    bool        reuseTree(const Board &board, int playerNumber);
+    int32_t     copySubtree(int32_t index);
+    SearchStats runWorker(const Board &board, int playerNumber, uint64_t playoutBudget, bool hasDeadline,
+                          std::chrono::steady_clock::time_point deadline, uint64_t randomSeed);
+    int32_t     expand(int32_t index, const Board &board, SearchStats &stats);
+    int32_t     selectChild(int32_t index, int32_t firstChild) const;
+    static int  playout(Board board, int playerNumber, uint64_t &randomState);
+    static uint64_t nextRandom(uint64_t &randomState);
+
+    std::unique_ptr<NodeArena<Node>> _tree;
+    std::unique_ptr<NodeArena<Node>> _spareTree;   // the next search copies the subtree it keeps into here
+    size_t      _arenaNodes;
+    int32_t     _root = NodeArena<Node>::kNone;
+    Board       _rootBoard;
+    int         _rootPlayer = 0;
+    uint64_t    _randomSeed = 0x9E3779B97F4A7C15ull;
+    std::unique_ptr<ThreadPool> _threadPool;            // made the first time more than one thread searches
+
+    std::atomic<uint64_t> _playoutsClaimed { 0 };       // the workers take playouts from the budget one at a time
+    SearchStats _searchStats;
+    std::vector<SearchStats> _threadStats;
+    std::atomic<bool> _searchCancelled { false };
+};
+
+// the board sizes the game offers, built once in MNKMCTS.cpp
+extern template class MNKMCTS<3, 3, 3>;
+extern template class MNKMCTS<4, 4, 4>;
+extern template class MNKMCTS<7, 6, 4>;
+extern template class MNKMCTS<15, 15, 5>;
@@ -0,0 +1,166 @@
+#include "MNKOpeningBook.h"
+#include "MNKAI.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+template<int W, int H, int K>
+typename MNKOpeningBook<W, H, K>::FileHeader MNKOpeningBook<W, H, K>::expectedHeader(int bookPlayer)
+{
+    FileHeader header = {};
+    std::memcpy(header.magic, "MNKBK01", 8);
+    header.width = W;
+    header.height = H;
+    header.winLength = K;
+    header.bookPlayer = (uint32_t)bookPlayer;
+    return header;
+}
+
+template<int W, int H, int K>
+typename MNKOpeningBook<W, H, K>::Mask MNKOpeningBook<W, H, K>::replies(const Board &board, int replyRadius)
+{
+    Mask empty = board.emptyCells();
+    if (Board::kCells <= 64 || !board.occupied()) return empty;
+
+    Mask near = {};
+    for (Mask cells = board.occupied(); cells; cells = MaskOps::withoutLowest(cells))
+    {
+        int cell = MaskOps::lowest(cells);
+        int row = cell / W;
+        int column = cell % W;
+        for (int r = std::max(0, row - replyRadius); r <= std::min(H - 1, row + replyRadius); r++)
+        {
+            for (int c = std::max(0, column - replyRadius); c <= std::min(W - 1, column + replyRadius); c++) near |= MaskOps::bit<Mask>(r * W + c);
+        }
+    }
+    return near & empty;
+}
+
+template<int W, int H, int K>
+bool MNKOpeningBook<W, H, K>::build(const std::string &path, ThreadPool &pool, const BuildSettings &settings)
+{
+    // one search per pool thread at a time, so every thread gets its own AI and transposition table
+    std::vector<std::unique_ptr<MNKAI<W, H, K>>> ais;
+    for (unsigned int i = 0; i < pool.size(); i++) ais.push_back(std::make_unique<MNKAI<W, H, K>>());
+
+    std::vector<Entry> entries;
+    std::vector<Board> frontier = { Board() };
+    for (int ply = 0; ply < settings.plies && !frontier.empty(); ply++)
+    {
+        int side = ply % 2;
+        std::vector<Board> next;
+        if (side == settings.bookPlayer)
+        {
+            std::vector<Entry> found(frontier.size());
+            std::vector<int> moves(frontier.size(), -1);
+            std::vector<std::future<void>> searches;
+            for (size_t i = 0; i < frontier.size(); i++)
+            {
+                searches.push_back(pool.submit([&ais, &frontier, &found, &moves, &settings, i, side]()
+                {
+                    MNKAI<W, H, K> &ai = *ais[ThreadPool::workerIndex()];
+                    int move = ai.searchBestMove(frontier[i], side, Board::kCells, settings.timeBudgetMs, 1);
+                    if (move < 0) return;
+                    CanonicalKey key = Position(frontier[i]).canonicalKey();
+                    const SearchStats &stats = ai.searchStats();
+                    found[i] = { key.key, (uint16_t)Symmetry::mapCell(move, key.transform), (uint16_t)stats.completedDepth,
+                                 (uint32_t)std::min<uint64_t>(stats.nodes, UINT32_MAX) };
+                    moves[i] = move;
+                }));
+            }
+            for (auto &search : searches) search.get();
+
+            for (size_t i = 0; i < frontier.size(); i++)
+            {
+                if (moves[i] < 0) continue;
+                entries.push_back(found[i]);
+                Board child = frontier[i].withMove(moves[i], side);
+                if (child.winnerAfterMove(moves[i]) == Board::kNoWinner && !child.isFull()) next.push_back(child);
+            }
+        }
+        else
+        {
+            // replies that land on the same position up to symmetry are only followed once
+            std::unordered_set<uint64_t> seen;
+            for (const Board &board : frontier)
+            {
+                for (Mask cells = replies(board, settings.replyRadius); cells; cells = MaskOps::withoutLowest(cells))
+                {
+                    int cell = MaskOps::lowest(cells);
+                    Board child = board.withMove(cell, side);
+                    if (child.winnerAfterMove(cell) != Board::kNoWinner || child.isFull()) continue;
+                    if (seen.insert(Position(child).canonicalKey().key).second) next.push_back(child);
+                }
+            }
+        }
+        frontier = std::move(next);
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.key < b.key; });
+    entries.erase(std::unique(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.key == b.key; }), entries.end());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    FileHeader header = expectedHeader(settings.bookPlayer);
+    header.entries = entries.size();
+    file.write((const char *)&header, sizeof(header));
+    file.write((const char *)entries.data(), (std::streamsize)(entries.size() * sizeof(Entry)));
+    return (bool)file;
+}
+
+template<int W, int H, int K>
+bool MNKOpeningBook<W, H, K>::load(const std::string &path)
+{
+    unload();
+    if (!_file.open(path)) return false;
+
+    // any book player will do, the positions only come up when it's that side's turn
+    FileHeader header;
+    FileHeader expected = expectedHeader(0);
+    bool valid = _file.size() >= sizeof(header);
+    if (valid)
+    {
+        std::memcpy(&header, _file.data(), sizeof(header));
+        valid = std::memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0 && header.width == expected.width
+             && header.height == expected.height && header.winLength == expected.winLength
+             && _file.size() == sizeof(header) + header.entries * sizeof(Entry);
+    }
+    if (!valid)
+    {
+        _file.close();
+        return false;
+    }
+    _entries = (const Entry *)(_file.data() + sizeof(header));
+    _entryCount = header.entries;
+    return true;
+}
+
+template<int W, int H, int K>
+void MNKOpeningBook<W, H, K>::unload()
+{
+    _file.close();
+    _entries = nullptr;
+    _entryCount = 0;
+}
+
+template<int W, int H, int K>
+int MNKOpeningBook<W, H, K>::bestMove(const Board &board) const
+{
+    if (!isLoaded()) return -1;
+    CanonicalKey key = Position(board).canonicalKey();
+    const Entry *end = _entries + _entryCount;
+    const Entry *entry = std::lower_bound(_entries, end, key.key, [](const Entry &e, uint64_t k) { return e.key < k; });
+    if (entry == end || entry->key != key.key || entry->move >= Board::kCells) return -1;
+
+    // a key collision could point at a full cell, that's a miss rather than a move
+    int move = Symmetry::unmapCell(entry->move, key.transform);
+    return MaskOps::test(board.emptyCells(), move) ? move : -1;
+}
+
+template class MNKOpeningBook<7, 6, 4>;
+template class MNKOpeningBook<15, 15, 5>;
@@ -0,0 +1,83 @@
+#pragma once
+#include "MNKBoard.h"
+#include "MappedFile.h"
+#include "SearchBoard.h"
+#include <cstdint>
+#include <string>
+
+class ThreadPool;
+
+//
+// the first few moves of a game searched ahead of time and read back from a memory-mapped file
+// the opening is where the board is emptiest, so it's the slowest part to search and the same few
+// positions come up game after game; looking them up instead makes those moves free
+// positions are stored once per symmetry class: the key is SearchBoard's canonical key and the move is
+// kept in the canonical image's frame, so it's mapped back through the transform of the board asked about
+// the file is the entries sorted by key, a lookup is a binary search over the mapping, and nothing in it
+// is ever written after build() so every process on the machine can share the same pages
+//
+template<int W, int H, int K>
+class MNKOpeningBook
+{
+public:
+    using Board = MNKBoard<W, H, K>;
+    using Mask = typename Board::Mask;
+    using Position = SearchBoard<W, H, K>;
+    using Symmetry = BoardSymmetry<W, H>;
+
+    struct BuildSettings
+    {
+        int  bookPlayer = 1;        // the side the book plays for, the other side's replies are all followed
+        int  plies = 4;             // book positions are the ones with fewer pieces than this
+        int  timeBudgetMs = 1000;   // per book position
+        int  replyRadius = 2;       // on boards over 64 cells, replies are only followed this close to a piece
+    };
+
+    //
+    // walk the opening a ply at a time: the bookPlayer's positions are searched (one per pool thread at a time,
+    // each thread with its own MNKAI) and only the chosen move is followed, the other side's every reply is
+    // followed; false if the file can't be written
+    //
+    static bool build(const std::string &path, ThreadPool &pool, const BuildSettings &settings);
+
+    // map a book made by build(), false if it's missing or was made for another board
+    bool        load(const std::string &path);
+    void        unload();
+    bool        isLoaded() const { return _entries != nullptr; }
+    uint64_t    size() const { return _entryCount; }
+
+    // the book move for the side to move, -1 if the position isn't in the book
+    int         bestMove(const Board &board) const;
+
+private:
+    struct FileHeader
+    {
+        char     magic[8];
+        uint32_t width;
+        uint32_t height;
+        uint32_t winLength;
+        uint32_t bookPlayer;
+        uint64_t entries;
+    };
+
+    struct Entry
+    {
+        uint64_t key;
+        uint16_t move;          // in the canonical image's frame
+        uint16_t depth;         // the search depth it was chosen at
+        uint32_t nodes;         // what choosing it cost, clamped
+    };
+    static_assert(sizeof(Entry) == 16);
+
+    static FileHeader expectedHeader(int bookPlayer);
+    // cells a reply gets followed on: every empty one, or on big boards the ones near a piece
+    static Mask replies(const Board &board, int replyRadius);
+
+    MappedFile  _file;
+    const Entry *_entries = nullptr;
+    uint64_t    _entryCount = 0;
+};
+
+// the boards too big to solve outright, built once in MNKOpeningBook.cpp
+extern template class MNKOpeningBook<7, 6, 4>;
+extern template class MNKOpeningBook<15, 15, 5>;
@@ -0,0 +1,261 @@
+#include "MNKProofSearch.h"
+#include "LineEvaluator.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+
+static Logger &logger = Logger::GetInstance();
+
+// proving "player 0 wins" and "player 1 wins" are different questions about the same position
+static constexpr uint64_t kAttackerKeys[2] = { 0x2545F4914F6CDD1Dull, 0x9E3779B97F4A7C15ull };
+
+static const char *kOutcomeNames[] = { "unknown", "win", "loss", "draw", "no forced win" };
+
+template<int W, int H, int K>
+MNKProofSearch<W, H, K>::MNKProofSearch(int tableBits) :
+    _table((size_t)1 << tableBits, Entry { 0, 0, 0 }),
+    _mask(((uint64_t)1 << tableBits) - 1)
+{
+}
+
+template<int W, int H, int K>
+void MNKProofSearch<W, H, K>::clearTable()
+{
+    std::fill(_table.begin(), _table.end(), Entry { 0, 0, 0 });
+}
+
+template<int W, int H, int K>
+uint64_t MNKProofSearch<W, H, K>::tableKey(const Position &position) const
+{
+    return position.canonicalKey().key ^ kAttackerKeys[_attacker];
+}
+
+template<int W, int H, int K>
+bool MNKProofSearch<W, H, K>::lookup(uint64_t key, uint32_t &proof, uint32_t &disproof)
+{
+    const Entry &entry = _table[key & _mask];
+    if (entry.key != key || (entry.proof | entry.disproof) == 0)
+    {
+        _searchStats.tableMisses++;
+        return false;
+    }
+    _searchStats.tableHits++;
+    proof = entry.proof;
+    disproof = entry.disproof;
+    return true;
+}
+
+// always replace, the newest numbers are the ones the search is about to need again
+template<int W, int H, int K>
+void MNKProofSearch<W, H, K>::store(uint64_t key, uint32_t proof, uint32_t disproof)
+{
+    _table[key & _mask] = { key, proof, disproof };
+}
+
+//
+// the moves worth trying for playerNumber, or whether the position is already decided
+// a line one move from done is won at once; two of them for the opponent can't both be blocked;
+// one of them has to be blocked, so that's the only move; on big boards the attacker
+// also only gets the moves that make a threat of its own
+//
+template<int W, int H, int K>
+typename MNKProofSearch<W, H, K>::Forced MNKProofSearch<W, H, K>::candidateMoves(const Board &board, int playerNumber, Mask &moves, int &winningCell) const
+{
+    using Evaluator = LineEvaluator<W, H, K>;
+    auto mine = Evaluator::template scanLines<!kFullWidth>(board.pieces[playerNumber], board.pieces[1 - playerNumber]);
+    if (mine.threats)
+    {
+        winningCell = MaskOps::lowest(mine.threats);
+        return kMoverWins;
+    }
+    auto theirs = Evaluator::scanLines(board.pieces[1 - playerNumber], board.pieces[playerNumber]);
+    int theirThreats = MaskOps::count(theirs.threats);
+    if (theirThreats >= 2) return kMoverLoses;
+
+    moves = theirThreats ? theirs.threats : board.emptyCells();
+    if (!kFullWidth && playerNumber == _attacker) moves &= mine.threatMakers;
+    return kNotForced;
+}
+
+//
+// the df-pn step: keep working on the most promising child until this position's proof or
+// disproof number reaches its threshold, which means some other position is now cheaper to settle
+// numbers are kept for the attacker throughout; the attacker picks the child with the smallest proof
+// number, the defender the one with the smallest disproof number, and each child gets the threshold
+// at which it would stop being the best choice
+//
+template<int W, int H, int K>
+void MNKProofSearch<W, H, K>::mid(Position &position, int playerNumber, uint32_t proofThreshold, uint32_t disproofThreshold,
+                                  uint32_t &proof, uint32_t &disproof, int ply)
+{
+    _searchStats.nodes++;
+    _searchStats.maxDepth = std::max(_searchStats.maxDepth, ply);
+    if (_searchStats.nodes >= _nodeBudget || _searchCancelled.load(std::memory_order_relaxed)) _outOfNodes = true;
+
+    bool attackerToMove = playerNumber == _attacker;
+    uint64_t key = tableKey(position);
+    Mask moves = {};
+    int winningCell = -1;
+    Forced forced = candidateMoves(position.board(), playerNumber, moves, winningCell);
+    if (forced != kNotForced || !moves)
+    {
+        // nothing left to try is a draw, and a draw isn't a win for the attacker
+        bool attackerWins = forced != kNotForced && (forced == kMoverWins) == attackerToMove;
+        proof = attackerWins ? 0 : kInfinity;
+        disproof = attackerWins ? kInfinity : 0;
+        store(key, proof, disproof);
+        _searchStats.terminalHits++;
+        return;
+    }
+
+    typename Board::MoveList children;
+    for (int cell : Board::kMoveOrder)
+    {
+        if (MaskOps::test(moves, cell)) children.push(cell);
+    }
+
+    while (true)
+    {
+        // the side to move takes its best child, so that child's number is ours;
+        // the other side's number is the sum, it has to beat every child
+        uint32_t best = kInfinity + 1, secondBest = kInfinity + 1, sum = 0, bestOther = 0;
+        int bestChild = 0;
+        for (int i = 0; i < children.size(); i++)
+        {
+            uint32_t childProof = 1, childDisproof = 1;
+            position.makeMove(children[i], playerNumber);
+            lookup(tableKey(position), childProof, childDisproof);
+            position.unmakeMove(children[i], playerNumber);
+
+            uint32_t value = attackerToMove ? childProof : childDisproof;
+            uint32_t other = attackerToMove ? childDisproof : childProof;
+            sum = std::min(kInfinity, sum + other);
+            if (value < best)
+            {
+                secondBest = best;
+                best = value;
+                bestChild = i;
+                bestOther = other;
+            }
+            else if (value < secondBest)
+            {
+                secondBest = value;
+            }
+        }
+        proof = attackerToMove ? best : sum;
+        disproof = attackerToMove ? sum : best;
+        if (proof >= proofThreshold || disproof >= disproofThreshold || _outOfNodes) break;
+
+        uint32_t bestThreshold = std::min(attackerToMove ? proofThreshold : disproofThreshold, secondBest + 1);
+        uint32_t otherThreshold = (attackerToMove ? disproofThreshold : proofThreshold) - sum + bestOther;
+        uint32_t childProof = 0, childDisproof = 0;
+        int cell = children[bestChild];
+        position.makeMove(cell, playerNumber);
+        mid(position, 1 - playerNumber, attackerToMove ? bestThreshold : otherThreshold, attackerToMove ? otherThreshold : bestThreshold,
+            childProof, childDisproof, ply + 1);
+        position.unmakeMove(cell, playerNumber);
+    }
+    store(key, proof, disproof);
+}
+
+template<int W, int H, int K>
+void MNKProofSearch<W, H, K>::prove(const Board &board, int playerNumber, int attacker, uint64_t nodeBudget, uint32_t &proof, uint32_t &disproof)
+{
+    _attacker = attacker;
+    _nodeBudget = nodeBudget;
+    _outOfNodes = false;
+    Position position(board);
+    mid(position, playerNumber, kInfinity, kInfinity, proof, disproof, 0);
+}
+
+//
+// follow a proof back out of the table: the attacker plays a proven child, the defender
+// any child (they're all proven), until the attacker has a line one move from done
+// stops early if the table has lost part of the proof to newer positions
+//
+template<int W, int H, int K>
+void MNKProofSearch<W, H, K>::provenLine(const Board &board, int playerNumber, std::vector<int> &line)
+{
+    line.clear();
+    Position position(board);
+    for (int ply = 0; ply < Board::kCells; ply++)
+    {
+        Mask moves = {};
+        int winningCell = -1;
+        Forced forced = candidateMoves(position.board(), playerNumber, moves, winningCell);
+        if (forced == kMoverWins) line.push_back(winningCell);
+        if (forced != kNotForced) return;
+
+        int next = -1;
+        for (int cell : Board::kMoveOrder)
+        {
+            if (!MaskOps::test(moves, cell)) continue;
+            uint32_t proof = 1, disproof = 1;
+            position.makeMove(cell, playerNumber);
+            bool found = lookup(tableKey(position), proof, disproof);
+            position.unmakeMove(cell, playerNumber);
+            if (found && proof == 0)
+            {
+                next = cell;
+                break;
+            }
+        }
+        if (next < 0) return;
+        line.push_back(next);
+        position.makeMove(next, playerNumber);
+        playerNumber = 1 - playerNumber;
+    }
+}
+
+//
+// First try to prove the side to move wins; if that's disproven on a board small enough to
+// try every move, spend what's left of the budget on whether the opponent wins
+// This never touches the game, so it's safe to run on the AI worker thread
+//
+template<int W, int H, int K>
+const ProofResult &MNKProofSearch<W, H, K>::solve(const Board &board, int playerNumber, uint64_t nodeBudget)
+{
+    auto searchStart = std::chrono::steady_clock::now();
+    _searchStats = SearchStats();
+    _result = ProofResult();
+    _result.playerNumber = playerNumber;
+
+    uint32_t proof = 0, disproof = 0;
+    prove(board, playerNumber, playerNumber, nodeBudget, proof, disproof);
+    if (proof == 0)
+    {
+        _result.outcome = kProofWin;
+        provenLine(board, playerNumber, _result.line);
+        if (!_result.line.empty()) _result.bestMove = _result.line.front();
+    }
+    else if (disproof == 0)
+    {
+        _result.outcome = kProofNoWin;
+        if (kFullWidth && _searchStats.nodes < nodeBudget)
+        {
+            prove(board, playerNumber, 1 - playerNumber, nodeBudget, proof, disproof);
+            if (proof == 0)
+            {
+                _result.outcome = kProofLoss;
+                provenLine(board, playerNumber, _result.line);
+            }
+            else if (disproof == 0)
+            {
+                _result.outcome = kProofDraw;
+            }
+        }
+    }
+    _searchStats.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - searchStart).count();
+    _result.nodes = _searchStats.nodes;
+    _result.elapsedMs = _searchStats.elapsedMs;
+
+    logger.Event(std::string("Proof search: ") + kOutcomeNames[_result.outcome] + " for player " + std::to_string(playerNumber)
+                 + (_result.line.empty() ? "" : " in " + std::to_string(_result.line.size()) + " plies") + " after "
+                 + std::to_string(_searchStats.nodes) + " nodes in " + std::to_string(_searchStats.elapsedMs) + " ms");
+    return _result;
+}
+
+template class MNKProofSearch<3, 3, 3>;
+template class MNKProofSearch<4, 4, 4>;
+template class MNKProofSearch<7, 6, 4>;
+template class MNKProofSearch<15, 15, 5>;
@@ -0,0 +1,109 @@
+#pragma once
+#include "MNKBoard.h"
+#include "SearchBoard.h"
+#include "SearchStats.h"
+#include <atomic>
+#include <vector>
+
+//
+// what the proof search found out about a position, for the side to move
+//
+enum ProofOutcome : uint8_t
+{
+    kProofUnknown,          // the node budget ran out first
+    kProofWin,              // the side to move can force a win
+    kProofLoss,             // the opponent can force a win whatever the side to move does
+    kProofDraw,             // neither side can force a win
+    kProofNoWin             // the side to move can't force a win (on big boards: not by threats alone), a loss wasn't settled
+};
+
+struct ProofResult
+{
+    ProofOutcome outcome = kProofUnknown;
+    int          playerNumber = -1;     // the side to move it was solved for
+    int          bestMove = -1;         // first move of a proven win, -1 otherwise
+    std::vector<int> line;              // the proven line for a win or a loss, moves alternate starting with playerNumber
+    uint64_t     nodes = 0;
+    double       elapsedMs = 0.0;
+};
+
+//
+// depth-first proof-number search (df-pn), for proving wins rather than estimating them
+// instead of a score, every position gets a proof number (how many more leaves have to be shown to be
+// wins to prove the attacker wins here) and a disproof number (the same for showing it doesn't), and the
+// search always goes down the path that is cheapest to settle, so a forced win deep in the tree is found
+// without looking at the rest of it
+// the numbers live in a fixed size table rather than a tree, so memory use doesn't grow with the search,
+// and the search stops after a node budget
+// up to 64 cells every move is tried; on the bigger boards the attacker only tries moves that make a
+// threat (K - 1 in an open line), which forces the reply and keeps the tree narrow, so a win found there
+// is a real win but a failed search only means there's no win by threats alone
+//
+template<int W, int H, int K>
+class MNKProofSearch
+{
+public:
+    using Board = MNKBoard<W, H, K>;
+    using Mask = typename Board::Mask;
+    using Position = SearchBoard<W, H, K>;
+
+    static constexpr bool kFullWidth = Board::kCells <= 64;
+
+    // the table has 2^tableBits entries of 16 bytes
+    explicit MNKProofSearch(int tableBits = Board::kCells <= 16 ? 16 : 20);
+
+    // settle the position for playerNumber, the side to move, visiting at most nodeBudget positions
+    // the table is kept between calls, so solving the next position along a proven line is nearly free
+    const ProofResult &solve(const Board &board, int playerNumber, uint64_t nodeBudget);
+    void        clearTable();
+
+    // a running solve() gives up soon after this is set, it stays set until it's cleared
+    void        setCancelled(bool cancelled) { _searchCancelled = cancelled; }
+
+    const ProofResult &result() const { return _result; }
+    const SearchStats &searchStats() const { return _searchStats; }
+
+private:
+    static constexpr uint32_t kInfinity = 1u << 30;
+
+    struct Entry
+    {
+        uint64_t key;
+        uint32_t proof;         // 0 proven, kInfinity disproven; both 0 marks an empty slot
+        uint32_t disproof;
+    };
+
+    // how the side to move stands before any move is tried
+    enum Forced
+    {
+        kNotForced,
+        kMoverWins,             // has a line one move from done
+        kMoverLoses             // can't win at once and the opponent has two lines one move from done
+    };
+
+    Forced      candidateMoves(const Board &board, int playerNumber, Mask &moves, int &winningCell) const;
+    void        prove(const Board &board, int playerNumber, int attacker, uint64_t nodeBudget, uint32_t &proof, uint32_t &disproof);
+    void        mid(Position &position, int playerNumber, uint32_t proofThreshold, uint32_t disproofThreshold,
+                    uint32_t &proof, uint32_t &disproof, int ply);
+    void        provenLine(const Board &board, int playerNumber, std::vector<int> &line);
+
+    uint64_t    tableKey(const Position &position) const;
+    bool        lookup(uint64_t key, uint32_t &proof, uint32_t &disproof);
+    void        store(uint64_t key, uint32_t proof, uint32_t disproof);
+
+    std::vector<Entry> _table;
+    uint64_t    _mask;
+    int         _attacker = 0;
+    uint64_t    _nodeBudget = 0;
+    bool        _outOfNodes = false;
+
+    ProofResult _result;
+    SearchStats _searchStats;
+    std::atomic<bool> _searchCancelled { false };
+};
+
+// the board sizes the game offers, built once in MNKProofSearch.cpp
+extern template class MNKProofSearch<3, 3, 3>;
+extern template class MNKProofSearch<4, 4, 4>;
+extern template class MNKProofSearch<7, 6, 4>;
+extern template class MNKProofSearch<15, 15, 5>;
@@ -0,0 +1,220 @@
+#include "MNKTablebase.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <vector>
+
+template<int W, int H, int K>
+typename MNKTablebase<W, H, K>::FileHeader MNKTablebase<W, H, K>::expectedHeader()
+{
+    FileHeader header = {};
+    std::memcpy(header.magic, "MNKTB01", 8);
+    header.width = W;
+    header.height = H;
+    header.winLength = K;
+    header.states = kStates;
+    return header;
+}
+
+//
+// kTernaryDigits turns 9 cells at a time into their base 3 digits
+//
+template<int W, int H, int K>
+uint64_t MNKTablebase<W, H, K>::index(const Board &board)
+{
+    constexpr uint64_t kChunkStates = 19683;       // 3^9
+    uint64_t index = 0;
+    uint64_t scale = 1;
+    for (int shift = 0; shift < Board::kCells; shift += 9, scale *= kChunkStates)
+    {
+        uint32_t first = ((uint32_t)board.pieces[0] >> shift) & 511;
+        uint32_t second = ((uint32_t)board.pieces[1] >> shift) & 511;
+        index += scale * (kTernaryDigits[first] + 2u * kTernaryDigits[second]);
+    }
+    return index;
+}
+
+template<int W, int H, int K>
+int MNKTablebase<W, H, K>::sideToMove(const Board &board)
+{
+    int first = MaskOps::count(board.pieces[0]);
+    int second = MaskOps::count(board.pieces[1]);
+    if (first == second) return 0;
+    if (first == second + 1) return 1;
+    return -1;
+}
+
+template<int W, int H, int K>
+typename MNKTablebase<W, H, K>::Probe MNKTablebase<W, H, K>::unpack(uint8_t valueByte, uint8_t distanceByte, uint64_t index,
+                                                                     int pieceCount)
+{
+    Probe probe;
+    probe.value = (Value)((valueByte >> (2 * (index % 4))) & 3);
+    int moves = (distanceByte >> (4 * (index % 2))) & 15;
+    if (probe.value == kWin) probe.pliesToEnd = 2 * moves - 1;
+    else if (probe.value == kLoss) probe.pliesToEnd = 2 * moves;
+    else if (probe.value == kDraw) probe.pliesToEnd = Board::kCells - pieceCount;
+    return probe;
+}
+
+//
+// one board, every child already solved: win if some move leaves the opponent lost (soonest such win),
+// draw if some move draws, otherwise lost (latest such loss)
+// boards of one piece count share bytes, so the results are or'd in atomically; a child shares its bytes
+// with boards of this count too, so it's read atomically while other threads are writing them
+//
+template<int W, int H, int K>
+void MNKTablebase<W, H, K>::solveBoard(const Board &board, int sideToMove, uint8_t *values, uint8_t *distances)
+{
+    uint64_t boardIndex = index(board);
+    int pieceCount = board.pieceCount();
+    Value value = kLoss;
+    int moves = 0;
+
+    // the last player to move won, so the side to move has lost
+    if (board.winner() == Board::kNoWinner)
+    {
+        if (board.isFull()) value = kDraw;
+        int winMoves = 16;
+        int lossMoves = -1;
+        bool canDraw = false;
+        uint64_t digitValue = 1;
+        for (int cell = 0; cell < Board::kCells; cell++, digitValue *= 3)
+        {
+            if (!MaskOps::test(board.emptyCells(), cell)) continue;
+            uint64_t childIndex = boardIndex + digitValue * (uint64_t)(sideToMove + 1);
+            Probe child = unpack(std::atomic_ref<uint8_t>(values[childIndex / 4]).load(std::memory_order_relaxed),
+                                 std::atomic_ref<uint8_t>(distances[childIndex / 2]).load(std::memory_order_relaxed), childIndex,
+                                 pieceCount + 1);
+            if (child.value == kLoss) winMoves = std::min(winMoves, child.pliesToEnd / 2 + 1);
+            else if (child.value == kDraw) canDraw = true;
+            else lossMoves = std::max(lossMoves, (child.pliesToEnd + 1) / 2);
+        }
+        if (winMoves < 16)
+        {
+            value = kWin;
+            moves = winMoves;
+        }
+        else if (canDraw) value = kDraw;
+        else if (lossMoves >= 0) moves = lossMoves;
+    }
+
+    std::atomic_ref<uint8_t>(values[boardIndex / 4]).fetch_or(uint8_t(value << (2 * (boardIndex % 4))), std::memory_order_relaxed);
+    if (moves) std::atomic_ref<uint8_t>(distances[boardIndex / 2]).fetch_or(uint8_t(moves << (4 * (boardIndex % 2))), std::memory_order_relaxed);
+}
+
+//
+// every board with n pieces only looks at boards with n + 1, so the piece counts go from full down to empty
+// and within one count the occupied-cell masks are dealt out to the pool in chunks; each mask then tries
+// every way of splitting its pieces between the players with the right counts
+//
+template<int W, int H, int K>
+bool MNKTablebase<W, H, K>::generate(const std::string &path, ThreadPool &pool)
+{
+    std::vector<uint8_t> values(kValueBytes, 0);
+    std::vector<uint8_t> distances(kDistanceBytes, 0);
+    constexpr uint32_t kMasks = 1u << Board::kCells;
+    const uint32_t chunkSize = std::max<uint32_t>(64, kMasks / (pool.size() * 8));
+
+    for (int pieceCount = Board::kCells; pieceCount >= 0; pieceCount--)
+    {
+        int firstPieces = (pieceCount + 1) / 2;
+        int sideToMove = pieceCount % 2;
+        std::vector<std::future<void>> chunks;
+        for (uint32_t start = 0; start < kMasks; start += chunkSize)
+        {
+            uint32_t end = std::min(kMasks, start + chunkSize);
+            chunks.push_back(pool.submit([&values, &distances, start, end, pieceCount, firstPieces, sideToMove]()
+            {
+                for (uint32_t occupied = start; occupied < end; occupied++)
+                {
+                    if (std::popcount(occupied) != pieceCount) continue;
+                    // every subset of the occupied cells, counting down from all of them to none
+                    for (uint32_t first = occupied;; first = (first - 1) & occupied)
+                    {
+                        if (std::popcount(first) == firstPieces)
+                        {
+                            Board board;
+                            board.pieces[0] = (Mask)first;
+                            board.pieces[1] = (Mask)(occupied ^ first);
+                            solveBoard(board, sideToMove, values.data(), distances.data());
+                        }
+                        if (first == 0) break;
+                    }
+                }
+            }));
+        }
+        for (auto &chunk : chunks) chunk.get();
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    FileHeader header = expectedHeader();
+    file.write((const char *)&header, sizeof(header));
+    file.write((const char *)values.data(), (std::streamsize)values.size());
+    file.write((const char *)distances.data(), (std::streamsize)distances.size());
+    return (bool)file;
+}
+
+template<int W, int H, int K>
+bool MNKTablebase<W, H, K>::load(const std::string &path)
+{
+    unload();
+    if (!_file.open(path)) return false;
+    FileHeader header = expectedHeader();
+    if (_file.size() != sizeof(header) + kValueBytes + kDistanceBytes || std::memcmp(_file.data(), &header, sizeof(header)) != 0)
+    {
+        _file.close();
+        return false;
+    }
+    _values = _file.data() + sizeof(header);
+    _distances = _values + kValueBytes;
+    return true;
+}
+
+template<int W, int H, int K>
+void MNKTablebase<W, H, K>::unload()
+{
+    _file.close();
+    _values = nullptr;
+    _distances = nullptr;
+}
+
+template<int W, int H, int K>
+typename MNKTablebase<W, H, K>::Probe MNKTablebase<W, H, K>::probe(const Board &board) const
+{
+    if (!isLoaded() || sideToMove(board) < 0) return Probe();
+    uint64_t boardIndex = index(board);
+    return unpack(_values[boardIndex / 4], _distances[boardIndex / 2], boardIndex, board.pieceCount());
+}
+
+template<int W, int H, int K>
+int MNKTablebase<W, H, K>::bestMove(const Board &board) const
+{
+    int side = sideToMove(board);
+    if (!isLoaded() || side < 0 || board.isFull() || board.winner() != Board::kNoWinner) return -1;
+
+    // the child's value is the opponent's, so its loss is our win: sooner wins and later losses score higher
+    int bestMove = -1;
+    int bestScore = INT32_MIN;
+    for (int cell : Board::kMoveOrder)
+    {
+        if (!MaskOps::test(board.emptyCells(), cell)) continue;
+        Probe child = probe(board.withMove(cell, side));
+        int score = child.value == kLoss ? 1000 - child.pliesToEnd : child.value == kWin ? -1000 + child.pliesToEnd : 0;
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestMove = cell;
+        }
+    }
+    return bestMove;
+}
+
+template class MNKTablebase<3, 3, 3>;
+template class MNKTablebase<4, 4, 4>;
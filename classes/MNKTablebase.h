@@ -0,0 +1,89 @@
+#pragma once
+#include "MNKBoard.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+
+class ThreadPool;
+
+//
+// an m,n,k board solved ahead of time by retrograde analysis and read back from a memory-mapped file
+// every encodable board has a ternary index (digit i is the state string character at cell i), and the
+// file keeps 2 bits per index for its value to the side to move and 4 more for how far away the end is,
+// so looking a position up is two byte loads, one from each of the two regions, far apart in the file;
+// bestMove() looks up every child, so a cold lookup costs a few page faults the first time a region is touched
+// adding a piece always makes the index larger, so the generator solves the boards one piece count at a
+// time from a full board down, and the boards of one piece count are split across a ThreadPool
+// too big to bake into the binary like SolvedGame, 4x4 is 3^16 boards, a 32 MB file
+//
+template<int W, int H, int K>
+class MNKTablebase
+{
+public:
+    using Board = MNKBoard<W, H, K>;
+    using Mask = typename Board::Mask;
+
+    static_assert(Board::kCells <= 16, "the ternary index of a bigger board makes a file too big to map");
+
+    static constexpr uint64_t kStates = (uint64_t)MNKTables::powerOfThree(Board::kCells);
+
+    // the value of a board to the side to move, X (0) always moves first
+    enum Value : uint8_t
+    {
+        kNotStored,             // piece counts that can't happen, or no table loaded
+        kWin,
+        kLoss,
+        kDraw
+    };
+
+    struct Probe
+    {
+        Value value = kNotStored;
+        int   pliesToEnd = 0;   // with perfect play: the winner ends it as soon as it can, the loser holds out
+    };
+
+    // solve every board and write the table to path, false if the file can't be written
+    static bool generate(const std::string &path, ThreadPool &pool);
+
+    // map a table made by generate(), false if it's missing or was made for another board
+    bool        load(const std::string &path);
+    void        unload();
+    bool        isLoaded() const { return _values != nullptr; }
+
+    Probe       probe(const Board &board) const;
+    // the move that wins fastest, draws, or loses slowest, -1 if the game is over or the board isn't stored
+    int         bestMove(const Board &board) const;
+
+    static uint64_t index(const Board &board);
+    // 0 or 1, -1 when the piece counts can't happen
+    static int  sideToMove(const Board &board);
+
+private:
+    static constexpr uint64_t kValueBytes = (kStates + 3) / 4;
+    static constexpr uint64_t kDistanceBytes = (kStates + 1) / 2;
+
+    struct FileHeader
+    {
+        char     magic[8];
+        uint32_t width;
+        uint32_t height;
+        uint32_t winLength;
+        uint32_t reserved;
+        uint64_t states;
+    };
+    static FileHeader expectedHeader();
+
+    // distances are kept in moves of the side to move rather than plies, so they fit in 4 bits:
+    // a win in m of its moves is 2m - 1 plies, a loss after m of them is 2m plies, a draw is the empty cells left
+    // valueByte and distanceByte are the bytes holding index's entry in each table
+    static Probe unpack(uint8_t valueByte, uint8_t distanceByte, uint64_t index, int pieceCount);
+    static void solveBoard(const Board &board, int sideToMove, uint8_t *values, uint8_t *distances);
+
+    MappedFile  _file;
+    const uint8_t *_values = nullptr;
+    const uint8_t *_distances = nullptr;
+};
+
+// the boards that get a table, built once in MNKTablebase.cpp (3x3 is only there to check against SolvedGame)
+extern template class MNKTablebase<3, 3, 3>;
+extern template class MNKTablebase<4, 4, 4>;
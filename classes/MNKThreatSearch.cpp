@@ -0,0 +1,172 @@
+#include "MNKThreatSearch.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+
+static Logger &logger = Logger::GetInstance();
+
+template<int W, int H, int K>
+bool MNKThreatSearch<W, H, K>::outOfNodes()
+{
+    if (++_searchStats.nodes >= _nodeBudget || _searchCancelled.load(std::memory_order_relaxed)) _aborted = true;
+    return _aborted;
+}
+
+// the attacker's last move left it a four or a move that makes two of them, somewhere in within
+template<int W, int H, int K>
+bool MNKThreatSearch<W, H, K>::isThreat(const Mask &within)
+{
+    return _tracker.cells(Tracker::kFour, _attacker) || _tracker.doubleFours(_attacker, within);
+}
+
+//
+// the attacker to move: win now if there's a four, otherwise try every move that makes a threat,
+// fours before threes; if the defender has a four it has to be blocked, and that block has to be a threat too
+// a free move can only make a new double four in its own reach, one already there is tried by the fours pass,
+// but a forced block counts as a threat if it leaves a double four anywhere
+//
+template<int W, int H, int K>
+bool MNKThreatSearch<W, H, K>::attack(int threats, int ply)
+{
+    if (outOfNodes()) return false;
+    _searchStats.maxDepth = std::max(_searchStats.maxDepth, ply);
+    int attacker = _attacker;
+    const Mask &wins = _tracker.cells(Tracker::kFour, attacker);
+    if (wins)
+    {
+        _lines[ply][0] = (uint8_t)MaskOps::lowest(wins);
+        _lineLengths[ply] = 1;
+        return true;
+    }
+    if (threats == 0) return false;
+
+    Mask candidates = _tracker.cells(Tracker::kFour, 1 - attacker);
+    if (MaskOps::count(candidates) >= 2) return false;
+    bool blocking = (bool)candidates;
+    if (!candidates) candidates = _tracker.cells(Tracker::kThree, attacker) | _tracker.cells(Tracker::kTwo, attacker);
+
+    Mask fourMakers = _tracker.cells(Tracker::kThree, attacker);
+    for (int pass = 0; pass < 2; pass++)
+    {
+        Mask moves = pass == 0 ? Mask(candidates & fourMakers) : Mask(candidates & ~fourMakers);
+        for (int cell : Board::kMoveOrder)
+        {
+            if (!MaskOps::test(moves, cell)) continue;
+            _tracker.makeMove(cell, attacker);
+            bool won = isThreat(blocking ? Board::kFullMask : Tracker::kCellReach[cell]) && defend(threats - 1, ply + 1);
+            _tracker.unmakeMove(cell, attacker);
+            if (won)
+            {
+                _lines[ply][0] = (uint8_t)cell;
+                int length = std::min(_lineLengths[ply + 1], kMaxLine - 1);
+                std::copy(_lines[ply + 1].begin(), _lines[ply + 1].begin() + length, _lines[ply].begin() + 1);
+                _lineLengths[ply] = length + 1;
+                return true;
+            }
+            if (_aborted) return false;
+        }
+    }
+    return false;
+}
+
+//
+// the defender to move against a threat: a four has to be blocked where it is; a three can be answered
+// by any move that spoils every double four the attacker has, or by a four of the defender's own
+// a move spoils a double four only if it's in one of the attacker's K - 2 lines through that cell
+// the attacker wins only if it wins against every one of them, the line follows the first
+//
+template<int W, int H, int K>
+bool MNKThreatSearch<W, H, K>::defend(int threats, int ply)
+{
+    if (outOfNodes()) return false;
+    int attacker = _attacker;
+    int defender = 1 - attacker;
+    if (_tracker.cells(Tracker::kFour, defender)) return false;
+    _lineLengths[ply] = 0;
+    Mask attackerWins = _tracker.cells(Tracker::kFour, attacker);
+    if (MaskOps::count(attackerWins) >= 2) return true;
+
+    Mask replies = attackerWins;
+    if (!attackerWins)
+    {
+        replies = _tracker.cells(Tracker::kThree, defender);
+        Mask doubles = _tracker.doubleFours(attacker);
+        Mask blocks = _tracker.cells(Tracker::kThree, attacker);
+        for (Mask cells = doubles; cells; cells = MaskOps::withoutLowest(cells)) blocks &= Tracker::kCellReach[MaskOps::lowest(cells)];
+        for (Mask cells = blocks; cells; cells = MaskOps::withoutLowest(cells))
+        {
+            int cell = MaskOps::lowest(cells);
+            if (MaskOps::test(replies, cell)) continue;
+            _tracker.makeMove(cell, defender);
+            bool stops = !_tracker.doubleFours(attacker, doubles);
+            _tracker.unmakeMove(cell, defender);
+            if (stops) replies |= MaskOps::bit<Mask>(cell);
+        }
+    }
+
+    bool first = true;
+    for (int cell : Board::kMoveOrder)
+    {
+        if (!MaskOps::test(replies, cell)) continue;
+        _tracker.makeMove(cell, defender);
+        bool won = attack(threats, ply + 1);
+        _tracker.unmakeMove(cell, defender);
+        if (!won) return false;
+        if (first)
+        {
+            _lines[ply][0] = (uint8_t)cell;
+            int length = std::min(_lineLengths[ply + 1], kMaxLine - 1);
+            std::copy(_lines[ply + 1].begin(), _lines[ply + 1].begin() + length, _lines[ply].begin() + 1);
+            _lineLengths[ply] = length + 1;
+            first = false;
+        }
+    }
+    return true;
+}
+
+//
+// Look for the shortest threat win for playerNumber, one more threat each pass
+//
+template<int W, int H, int K>
+const ProofResult &MNKThreatSearch<W, H, K>::search(const Board &board, int playerNumber, int maxThreats, uint64_t nodeBudget)
+{
+    auto searchStart = std::chrono::steady_clock::now();
+    _searchStats = SearchStats();
+    _result = ProofResult();
+    _result.playerNumber = playerNumber;
+    _attacker = playerNumber;
+    _nodeBudget = nodeBudget;
+    _aborted = false;
+    _tracker.reset(board);
+
+    maxThreats = std::clamp(maxThreats, 1, kMaxThreats);
+    for (int threats = 1; threats <= maxThreats; threats++)
+    {
+        if (attack(threats, 0))
+        {
+            _result.outcome = kProofWin;
+            _result.line.assign(_lines[0].begin(), _lines[0].begin() + _lineLengths[0]);
+            _result.bestMove = _result.line.front();
+            _searchStats.completedDepth = threats;
+            break;
+        }
+        if (_aborted) break;
+        _searchStats.completedDepth = threats;
+    }
+    if (_result.outcome != kProofWin) _result.outcome = _aborted ? kProofUnknown : kProofNoWin;
+
+    _searchStats.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - searchStart).count();
+    _result.nodes = _searchStats.nodes;
+    _result.elapsedMs = _searchStats.elapsedMs;
+
+    logger.Event(std::string("Threat search: ") + (_result.outcome == kProofWin ? "win in " + std::to_string(_result.line.size()) + " plies"
+                 : _result.outcome == kProofNoWin ? "no win within " + std::to_string(maxThreats) + " threats" : "ran out of nodes")
+                 + " for player " + std::to_string(playerNumber) + " after " + std::to_string(_searchStats.nodes) + " nodes in "
+                 + std::to_string(_searchStats.elapsedMs) + " ms");
+    return _result;
+}
+
+template class MNKThreatSearch<3, 3, 3>;
+template class MNKThreatSearch<4, 4, 4>;
+template class MNKThreatSearch<7, 6, 4>;
+template class MNKThreatSearch<15, 15, 5>;
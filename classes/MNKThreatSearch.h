@@ -0,0 +1,65 @@
+#pragma once
+#include "MNKBoard.h"
+#include "MNKProofSearch.h"
+#include "SearchStats.h"
+#include "ThreatTracker.h"
+#include <array>
+#include <atomic>
+
+//
+// threat space search: looks for a win made only of threats, which is how big k-in-a-row boards are won
+// the attacker only plays moves that leave it a four (a line one move from done, which has to be blocked
+// at that cell) or a three (a move that would make two fours at once, which has to be stopped now);
+// the defender gets every reply that answers the threat, including making a four of its own, so a win
+// found here holds against anything, and the tree stays narrow enough to look many threats ahead
+// threats are kept up to date by a ThreatTracker as moves are made, and the search deepens one threat at a
+// time so the shortest win is the one found
+//
+template<int W, int H, int K>
+class MNKThreatSearch
+{
+public:
+    using Board = MNKBoard<W, H, K>;
+    using Mask = typename Board::Mask;
+    using Tracker = ThreatTracker<W, H, K>;
+
+    // longest threat sequence searched for
+    static constexpr int kMaxThreats = 16;
+
+    // look for a win for playerNumber, the side to move, of at most maxThreats threats, visiting at most
+    // nodeBudget positions; the result is kProofWin with the line, kProofNoWin or kProofUnknown if it ran out
+    const ProofResult &search(const Board &board, int playerNumber, int maxThreats, uint64_t nodeBudget);
+
+    // a running search() gives up soon after this is set, it stays set until it's cleared
+    void        setCancelled(bool cancelled) { _searchCancelled = cancelled; }
+
+    const ProofResult &result() const { return _result; }
+    const SearchStats &searchStats() const { return _searchStats; }
+
+private:
+    static constexpr int kMaxLine = 2 * kMaxThreats + 2;
+
+    bool        attack(int threats, int ply);
+    bool        defend(int threats, int ply);
+    bool        isThreat(const Mask &within);
+    bool        outOfNodes();
+
+    Tracker     _tracker;
+    int         _attacker = 0;
+    uint64_t    _nodeBudget = 0;
+    bool        _aborted = false;
+
+    // _lines[ply] is the winning line found from ply on, built back up as each win returns
+    std::array<std::array<uint8_t, kMaxLine>, kMaxLine + 1> _lines;
+    std::array<int, kMaxLine + 1> _lineLengths;
+
+    ProofResult _result;
+    SearchStats _searchStats;
+    std::atomic<bool> _searchCancelled { false };
+};
+
+// the board sizes the game offers, built once in MNKThreatSearch.cpp
+extern template class MNKThreatSearch<3, 3, 3>;
+extern template class MNKThreatSearch<4, 4, 4>;
+extern template class MNKThreatSearch<7, 6, 4>;
+extern template class MNKThreatSearch<15, 15, 5>;
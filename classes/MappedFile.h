@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//
+// a whole file mapped read-only into memory
+// nothing is read up front, the OS pages the file in as it's touched and shares those pages
+// between every process that maps the same file, so a big table costs a few page faults the first time
+// a region is touched rather than a read of the whole file
+//
+class MappedFile
+{
+public:
+    MappedFile() {}
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // false if the file can't be opened or is empty, any earlier mapping is closed either way
+    bool        open(const std::string &path);
+    void        close();
+
+    bool        isOpen() const { return _data != nullptr; }
+    const uint8_t *data() const { return _data; }
+    size_t      size() const { return _size; }
+
+private:
+    const uint8_t *_data = nullptr;
+    size_t      _size = 0;
+#ifdef _WIN32
+    void *      _file = nullptr;
+    void *      _mapping = nullptr;
+#endif
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+//
+// bump allocator for search tree nodes
+// all the memory is taken once up front, handing out nodes is an index increment and
+// throwing the whole tree away is resetting that index, so a search never calls new per node
+// and uses the same amount of memory every move
+// nodes are addressed by index, so a tree can be copied into another arena without fixing up pointers
+// several search threads can allocate at once, each allocation is one atomic add
+//
+template<class Node>
+class NodeArena
+{
+public:
+    static constexpr int32_t kNone = -1;
+
+    explicit NodeArena(size_t capacity) :
+        _nodes(new Node[capacity]),
+        _capacity(capacity),
+        _used(0)
+    {
+    }
+
+    // count nodes side by side, returns the first one's index or kNone once the arena is full
+    // a failed allocation still moves the index past the end, so every later one fails too
+    int32_t     allocate(int count)
+    {
+        size_t first = _used.fetch_add(count, std::memory_order_relaxed);
+        if (first + count > _capacity) return kNone;
+        for (int i = 0; i < count; i++) _nodes[first + i] = Node();
+        return (int32_t)first;
+    }
+
+    // only while no other thread is allocating
+    void        reset() { _used.store(0, std::memory_order_relaxed); }
+
+    Node       &operator[](int32_t index) { return _nodes[index]; }
+    const Node &operator[](int32_t index) const { return _nodes[index]; }
+
+    size_t      used() const { return std::min(_used.load(std::memory_order_relaxed), _capacity); }
+    size_t      capacity() const { return _capacity; }
+    size_t      bytes() const { return _capacity * sizeof(Node); }
+
+private:
+    std::unique_ptr<Node[]> _nodes;
+    size_t      _capacity;
+    std::atomic<size_t> _used;
+};
@@ -0,0 +1,141 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "MNKBoard.h"
+#include "BoardSymmetry.h"
+
+namespace MNKTables
+{
+    // splitmix64, a fixed seed keeps the random keys (and so the search) the same on every run
+    constexpr uint64_t nextRandom(uint64_t &state)
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    //
+    // kKeyWeights[t][player][cell] is what the player's piece on cell adds to the key of the image under t
+    // boards of up to 9 cells use the ternary index, which is a perfect hash and gets added up,
+    // anything bigger gets a Zobrist key, a random word per (player, cell) that gets xor'ed in
+    //
+    template<int W, int H>
+    constexpr std::array<std::array<std::array<uint64_t, W * H>, 2>, BoardSymmetry<W, H>::kTransforms> makeKeyWeights()
+    {
+        std::array<std::array<uint64_t, W * H>, 2> cellKeys = {};
+        uint64_t seed = 0x6D6E6B;
+        for (int player = 0; player < 2; player++)
+        {
+            for (int cell = 0; cell < W * H; cell++)
+            {
+                cellKeys[player][cell] = W * H <= 9 ? (uint64_t)(player + 1) * powerOfThree(cell) : nextRandom(seed);
+            }
+        }
+
+        std::array<std::array<std::array<uint64_t, W * H>, 2>, BoardSymmetry<W, H>::kTransforms> table = {};
+        for (int t = 0; t < BoardSymmetry<W, H>::kTransforms; t++)
+        {
+            for (int player = 0; player < 2; player++)
+            {
+                for (int cell = 0; cell < W * H; cell++) table[t][player][cell] = cellKeys[player][BoardSymmetry<W, H>::kCellMap[t][cell]];
+            }
+        }
+        return table;
+    }
+}
+
+struct CanonicalKey
+{
+    uint64_t key;           // key of the canonical image, the board's ternary index on 3x3
+    int      transform;     // maps the board onto the canonical image
+};
+
+//
+// the single board the search plays on
+// makeMove and unmakeMove change it in place instead of copying a board per node, and keep the
+// move counter and the key of every symmetric image up to date as they go,
+// so finding the transposition table slot is a few compares instead of mapping the board
+//
+template<int W, int H, int K>
+class SearchBoard
+{
+public:
+    using Board = MNKBoard<W, H, K>;
+    using Symmetry = BoardSymmetry<W, H>;
+
+    // true when the keys are ternary indices, which never collide
+    static constexpr bool kPerfectKeys = Board::kCells <= 9;
+
+    SearchBoard() { reset(Board()); }
+    explicit SearchBoard(const Board &board) { reset(board); }
+
+    void reset(const Board &board)
+    {
+        _board = board;
+        _moveCount = board.pieceCount();
+        for (int t = 0; t < Symmetry::kTransforms; t++) _imageKeys[t] = 0;
+        for (int player = 0; player < 2; player++)
+        {
+            for (auto cells = board.pieces[player]; cells; cells = MaskOps::withoutLowest(cells))
+            {
+                addPiece(MaskOps::lowest(cells), player);
+            }
+        }
+    }
+
+    // cell has to be empty
+    void makeMove(int cell, int playerNumber)
+    {
+        _board.pieces[playerNumber] |= MaskOps::bit<typename Board::Mask>(cell);
+        _moveCount++;
+        addPiece(cell, playerNumber);
+    }
+
+    // takes back the makeMove(cell, playerNumber) that was played last
+    void unmakeMove(int cell, int playerNumber)
+    {
+        _board.pieces[playerNumber] &= ~MaskOps::bit<typename Board::Mask>(cell);
+        _moveCount--;
+        removePiece(cell, playerNumber);
+    }
+
+    const Board &board() const { return _board; }
+    int         moveCount() const { return _moveCount; }
+
+    // the image with the smallest key is the canonical one, the first smallest wins a tie
+    CanonicalKey canonicalKey() const
+    {
+        CanonicalKey best = { _imageKeys[0], 0 };
+        for (int t = 1; t < Symmetry::kTransforms; t++)
+        {
+            if (_imageKeys[t] < best.key) best = { _imageKeys[t], t };
+        }
+        return best;
+    }
+
+private:
+    static constexpr auto kKeyWeights = MNKTables::makeKeyWeights<W, H>();
+
+    void addPiece(int cell, int playerNumber)
+    {
+        for (int t = 0; t < Symmetry::kTransforms; t++)
+        {
+            if constexpr (kPerfectKeys) _imageKeys[t] += kKeyWeights[t][playerNumber][cell];
+            else _imageKeys[t] ^= kKeyWeights[t][playerNumber][cell];
+        }
+    }
+
+    void removePiece(int cell, int playerNumber)
+    {
+        for (int t = 0; t < Symmetry::kTransforms; t++)
+        {
+            if constexpr (kPerfectKeys) _imageKeys[t] -= kKeyWeights[t][playerNumber][cell];
+            else _imageKeys[t] ^= kKeyWeights[t][playerNumber][cell];
+        }
+    }
+
+    Board       _board;
+    int         _moveCount;
+    uint64_t    _imageKeys[Symmetry::kTransforms];
+};
@@ -0,0 +1,45 @@
+#include "SearchStats.h"
+#include <algorithm>
+#include <fstream>
+
+SearchStats &SearchStats::operator+=(const SearchStats &other)
+{
+    nodes += other.nodes;
+    leafEvaluations += other.leafEvaluations;
+    terminalHits += other.terminalHits;
+    cutoffs += other.cutoffs;
+    tableHits += other.tableHits;
+    tableMisses += other.tableMisses;
+    maxDepth = std::max(maxDepth, other.maxDepth);
+    completedDepth = std::max(completedDepth, other.completedDepth);
+    playouts += other.playouts;
+    // threads run side by side, so the wall time is the longest one rather than the sum
+    elapsedMs = std::max(elapsedMs, other.elapsedMs);
+    return *this;
+}
+
+SearchStats &SearchStats::addPass(const SearchStats &pass)
+{
+    double totalMs = elapsedMs + pass.elapsedMs;
+    *this += pass;
+    elapsedMs = totalMs;
+    return *this;
+}
+
+bool WriteSearchRecords(const std::vector<SearchRecord> &records, const std::filesystem::path &filePath)
+{
+    std::ofstream file(filePath);
+    if (!file) return false;
+
+    file << "game,turn,board,move,nodes,leaf_evaluations,terminal_hits,cutoffs,table_hits,table_misses,"
+            "max_depth,completed_depth,playouts,elapsed_ms,nodes_per_second\n";
+    for (const auto &record : records)
+    {
+        const SearchStats &stats = record.stats;
+        file << record.gameNumber << ',' << record.turnNumber << ',' << record.boardState << ',' << record.move << ','
+             << stats.nodes << ',' << stats.leafEvaluations << ',' << stats.terminalHits << ',' << stats.cutoffs << ','
+             << stats.tableHits << ',' << stats.tableMisses << ',' << stats.maxDepth << ',' << stats.completedDepth << ','
+             << stats.playouts << ',' << stats.elapsedMs << ',' << (uint64_t)stats.nodesPerSecond() << '\n';
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+//
+// counters collected while the AI searches
+// each search thread fills its own copy (see t_searchStats in MNKAI.cpp) and they're
+// added together once the threads finish, so counting costs a few increments per node
+//
+struct SearchStats
+{
+    uint64_t nodes = 0;             // calls to negamax, or tree nodes added by MCTS
+    uint64_t leafEvaluations = 0;   // positions scored by evaluate() or played out at random
+    uint64_t terminalHits = 0;      // positions that were already won or drawn
+    uint64_t cutoffs = 0;           // times a move reached beta and the rest were skipped
+    uint64_t tableHits = 0;         // transposition table probes that found the position
+    uint64_t tableMisses = 0;
+    int      maxDepth = 0;          // deepest ply below the root that was visited
+    int      completedDepth = 0;    // last iterative deepening pass that finished
+    uint64_t playouts = 0;          // MCTS iterations, 0 for negamax
+    double   elapsedMs = 0.0;
+
+    double   nodesPerSecond() const { return elapsedMs > 0.0 ? nodes * 1000.0 / elapsedMs : 0.0; }
+    double   playoutsPerSecond() const { return elapsedMs > 0.0 ? playouts * 1000.0 / elapsedMs : 0.0; }
+
+    // threads run side by side, so adding another thread's stats keeps the longer of the two times
+    SearchStats &operator+=(const SearchStats &other);
+    // a later pass on the same thread ran after this one, so its time adds on
+    SearchStats &addPass(const SearchStats &pass);
+};
+
+//
+// one line of the per-move export, which move the AI played and what it cost to find
+//
+struct SearchRecord
+{
+    int         gameNumber;
+    int         turnNumber;
+    std::string boardState;
+    int         move;
+    SearchStats stats;
+};
+
+// write the records as CSV, one row per AI move
+bool WriteSearchRecords(const std::vector<SearchRecord> &records, const std::filesystem::path &filePath);
@@ -0,0 +1,112 @@
+#include "SolvedGame.h"
+#include <array>
+
+namespace SolvedGame
+{
+    static constexpr int sideToMoveFor(const TicTacToeBoard &board)
+    {
+        int xCount = std::popcount(board.pieces[0]);
+        int oCount = std::popcount(board.pieces[1]);
+        if (xCount == oCount) return 0;
+        if (xCount == oCount + 1) return 1;
+        return -1;
+    }
+
+    //
+    // retrograde pass over every board
+    // adding a piece always makes the ternary index larger, so walking the indices from the top
+    // down means every child has already been solved by the time we reach its parent
+    //
+    static constexpr std::array<Entry, TicTacToeBoard::kStates> solve()
+    {
+        std::array<Entry, TicTacToeBoard::kStates> table = {};
+
+        for (int index = TicTacToeBoard::kStates - 1; index >= 0; index--)
+        {
+            TicTacToeBoard board = TicTacToeBoard::fromTernaryIndex(index);
+            Entry &entry = table[index];
+            entry.bestMoves = 0;
+
+            int side = sideToMoveFor(board);
+            if (side < 0)
+            {
+                entry.score = kIllegal;
+                continue;
+            }
+            // The last player to move won, so the side to move has lost
+            if (board.winner() >= 0)
+            {
+                entry.score = -kWinScore;
+                continue;
+            }
+            if (board.isFull())
+            {
+                entry.score = 0;
+                continue;
+            }
+
+            int best = -kWinScore - 1;
+            for (int cell = 0; cell < TicTacToeBoard::kCells; cell++)
+            {
+                if (!(board.emptyCells() & (1u << cell))) continue;
+
+                // Flip the child's score to our side and push it one ply further away
+                int childScore = table[board.withMove(cell, side).ternaryIndex()].score;
+                int score = -childScore;
+                if (score > 0) score--;
+                else if (score < 0) score++;
+
+                if (score > best)
+                {
+                    best = score;
+                    entry.bestMoves = 0;
+                }
+                if (score == best) entry.bestMoves |= uint16_t(1u << cell);
+            }
+            entry.score = (int8_t)best;
+        }
+
+        return table;
+    }
+
+    static constexpr std::array<Entry, TicTacToeBoard::kStates> kTable = solve();
+
+    // sanity checks on the baked table: the empty board is a draw and a corner opening still draws
+    static_assert(kTable[TicTacToeBoard().ternaryIndex()].score == 0);
+    static_assert(kTable[TicTacToeBoard().withMove(0, 0).ternaryIndex()].score == 0);
+
+    const Entry &lookup(const TicTacToeBoard &board)
+    {
+        return kTable[board.ternaryIndex()];
+    }
+
+    int sideToMove(const TicTacToeBoard &board)
+    {
+        return sideToMoveFor(board);
+    }
+
+    int value(const TicTacToeBoard &board)
+    {
+        int score = lookup(board).score;
+        if (score == kIllegal || score == 0) return 0;
+        return score > 0 ? 1 : -1;
+    }
+
+    int pliesToEnd(const TicTacToeBoard &board)
+    {
+        int score = lookup(board).score;
+        if (score == kIllegal) return 0;
+        if (score == 0) return std::popcount(board.emptyCells());
+        return kWinScore - (score > 0 ? score : -score);
+    }
+
+    int bestMove(const TicTacToeBoard &board)
+    {
+        uint16_t moves = lookup(board).bestMoves;
+        for (int cell : TicTacToeBoard::kMoveOrder)
+        {
+            if (moves & (1u << cell)) return cell;
+        }
+        return -1;
+    }
+}
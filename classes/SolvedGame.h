@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include "TicTacToeBoard.h"
+
+//
+// tic tac toe solved ahead of time: the compiler walks every one of the 3^9 encodable
+// boards and bakes the game-theoretic value and the best moves into the binary,
+// so the AI (and any hint or analysis) is a single array load at runtime
+//
+namespace SolvedGame
+{
+    // scores are from the point of view of the side to move
+    // a win in n plies scores kWinScore - n, a loss in n plies -(kWinScore - n), a draw 0
+    static constexpr int8_t kWinScore = 10;
+    static constexpr int8_t kIllegal  = INT8_MIN;   // piece counts that can't happen with X moving first
+
+    struct Entry
+    {
+        int8_t   score;
+        uint16_t bestMoves;     // mask of every move that keeps the score, 0 when the game is over
+    };
+
+    const Entry &lookup(const TicTacToeBoard &board);
+
+    // side to move, X (0) always moves first, -1 for an illegal board
+    int         sideToMove(const TicTacToeBoard &board);
+    // -1, 0 or 1 for a loss, draw or win with perfect play
+    int         value(const TicTacToeBoard &board);
+    // how many plies the game lasts with perfect play from here
+    int         pliesToEnd(const TicTacToeBoard &board);
+    // one of the best moves, picking center, then corners, then edges, or -1 if there isn't one
+    int         bestMove(const TicTacToeBoard &board);
+}
@@ -7,6 +7,12 @@
 // Simple helper function to load an image into a OpenGL texture with common settings
 bool Sprite::LoadTextureFromFile(const char* filename)
 {
+#ifdef SPRITE_HEADLESS
+    // no renderer to upload to, keep the sprite invisible and skip the file entirely
+    _texture = 0;
+    _size = ImVec2(0, 0);
+    return true;
+#else
     // Load from file
     int image_width = 0;
     int image_height = 0;
@@ -26,6 +32,7 @@ bool Sprite::LoadTextureFromFile(const char* filename)
     }
     _size = ImVec2((float)image_width, (float)image_height);
     return true;
+#endif
 }
 
 void Sprite::setHighlighted(bool highlighted)
@@ -40,7 +47,15 @@ bool Sprite::highlighted()
 	return _highlighted;
 }
 
-#ifdef __APPLE__
+#if defined(SPRITE_HEADLESS)
+
+// built without a window (the benchmarks), there's nothing to create a texture with
+ImTextureID Sprite::_loadTextureFromMemory(const unsigned char *image_data, int image_width, int image_height)
+{
+    return 0;
+}
+
+#elif defined(__APPLE__)
 #include "../imgui/imgui_impl_opengl3_loader.h"
 
 ImTextureID Sprite::_loadTextureFromMemory(const unsigned char *image_data, int image_width, int image_height)
@@ -0,0 +1,50 @@
+#include "ThreadPool.h"
+
+static thread_local int t_workerIndex = -1;
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+    _stopping = false;
+    if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0) threadCount = 1;      // hardware_concurrency() is allowed to not know
+
+    for (unsigned int i = 0; i < threadCount; i++)
+    {
+        _workers.emplace_back(&ThreadPool::workerLoop, this, (int)i);
+    }
+}
+
+//
+// finish whatever is already queued, then join the workers
+//
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wakeUp.notify_all();
+    for (auto &worker : _workers) worker.join();
+}
+
+int ThreadPool::workerIndex()
+{
+    return t_workerIndex;
+}
+
+void ThreadPool::workerLoop(int index)
+{
+    t_workerIndex = index;
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wakeUp.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+            if (_tasks.empty()) return;
+            task = std::move(_tasks.front());
+            _tasks.pop();
+        }
+        task();
+    }
+}
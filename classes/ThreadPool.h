@@ -0,0 +1,50 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+//
+// a fixed set of worker threads that run queued tasks
+// the AI keeps one around for the whole session so a parallel search doesn't pay for thread startup
+//
+class ThreadPool
+{
+public:
+    // 0 threads means one per hardware thread
+    explicit ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    unsigned int size() const { return (unsigned int)_workers.size(); }
+
+    // index of the pool worker running the calling code, or -1 when called from outside the pool
+    static int  workerIndex();
+
+    // queue a task and get a future for its result
+    template<class Task>
+    auto        submit(Task &&task) -> std::future<decltype(task())>
+    {
+        using Result = decltype(task());
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<Task>(task));
+        std::future<Result> result = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _tasks.push([packaged]() { (*packaged)(); });
+        }
+        _wakeUp.notify_one();
+        return result;
+    }
+
+private:
+    void        workerLoop(int index);
+
+    std::vector<std::thread>            _workers;
+    std::queue<std::function<void()>>   _tasks;
+    std::mutex                          _mutex;
+    std::condition_variable             _wakeUp;
+    bool                                _stopping;
+};
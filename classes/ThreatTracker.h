@@ -0,0 +1,184 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "MNKBoard.h"
+
+namespace MNKTables
+{
+    // the cells of every line, in the same order as makeWinMasks()
+    template<int W, int H, int K>
+    constexpr std::array<std::array<uint8_t, K>, lineCount(W, H, K)> makeLineCells()
+    {
+        std::array<std::array<uint8_t, K>, lineCount(W, H, K)> cells = {};
+        constexpr int kSteps[4][2] = { { 0, 1 }, { 1, 0 }, { 1, 1 }, { 1, -1 } };   // row, column steps
+        int line = 0;
+        for (const auto &step : kSteps)
+        {
+            for (int row = 0; row < H; row++)
+            {
+                for (int column = 0; column < W; column++)
+                {
+                    int lastRow = row + step[0] * (K - 1);
+                    int lastColumn = column + step[1] * (K - 1);
+                    if (lastRow < 0 || lastRow >= H || lastColumn < 0 || lastColumn >= W) continue;
+                    for (int i = 0; i < K; i++) cells[line][i] = (uint8_t)((row + step[0] * i) * W + column + step[1] * i);
+                    line++;
+                }
+            }
+        }
+        return cells;
+    }
+
+    // every cell that shares a line with the cell, and the cell itself
+    template<class Mask, int W, int H, int K>
+    constexpr std::array<Mask, W * H> makeCellReach()
+    {
+        constexpr auto masks = makeWinMasks<Mask, W, H, K>();
+        constexpr auto cellLines = makeCellLines<Mask, W, H, K>();
+        std::array<Mask, W * H> reach = {};
+        for (int cell = 0; cell < W * H; cell++)
+        {
+            for (int i = 0; i < cellLines[cell].count; i++) reach[cell] |= masks[cellLines[cell].lines[i]];
+        }
+        return reach;
+    }
+}
+
+//
+// keeps track of every player's threats as pieces come and go, for the threat space search
+// each line of K cells holds a count of both players' pieces, and every empty cell of a line only one
+// player is in gets counted by how close that line is to done:
+//   kFour  - the line has K - 1 pieces, the cell wins
+//   kThree - K - 2 pieces, the cell makes a four
+//   kTwo   - K - 3 pieces, the cell is a step towards a three
+// a move only changes the lines through its cell, so makeMove and unmakeMove take back those lines'
+// old counts and add their new ones, rather than scanning the board again
+//
+template<int W, int H, int K>
+class ThreatTracker
+{
+public:
+    using Board = MNKBoard<W, H, K>;
+    using Mask = typename Board::Mask;
+
+    enum Level
+    {
+        kFour,
+        kThree,
+        kTwo,
+        kLevels
+    };
+
+    static constexpr auto kLineCells = MNKTables::makeLineCells<W, H, K>();
+    // a move can only change the threats on cells in its reach
+    static constexpr std::array<Mask, Board::kCells> kCellReach = MNKTables::makeCellReach<Mask, W, H, K>();
+
+    ThreatTracker() { reset(Board()); }
+    explicit ThreatTracker(const Board &board) { reset(board); }
+
+    void reset(const Board &board)
+    {
+        _board = Board();
+        _lineCounts = {};
+        _cellCounts = {};
+        _cells = {};
+        for (int line = 0; line < Board::kLines; line++) update(line, 1);
+        for (int player = 0; player < 2; player++)
+        {
+            for (auto cells = board.pieces[player]; cells; cells = MaskOps::withoutLowest(cells)) makeMove(MaskOps::lowest(cells), player);
+        }
+    }
+
+    // cell has to be empty
+    void makeMove(int cell, int playerNumber)
+    {
+        const auto &lines = Board::kCellLines[cell];
+        for (int i = 0; i < lines.count; i++) update(lines.lines[i], -1);
+        _board.pieces[playerNumber] |= MaskOps::bit<Mask>(cell);
+        for (int i = 0; i < lines.count; i++)
+        {
+            _lineCounts[playerNumber][lines.lines[i]]++;
+            update(lines.lines[i], 1);
+        }
+    }
+
+    // takes back the makeMove(cell, playerNumber) that was played last
+    void unmakeMove(int cell, int playerNumber)
+    {
+        const auto &lines = Board::kCellLines[cell];
+        for (int i = 0; i < lines.count; i++) update(lines.lines[i], -1);
+        _board.pieces[playerNumber] &= ~MaskOps::bit<Mask>(cell);
+        for (int i = 0; i < lines.count; i++)
+        {
+            _lineCounts[playerNumber][lines.lines[i]]--;
+            update(lines.lines[i], 1);
+        }
+    }
+
+    const Board &board() const { return _board; }
+
+    // empty cells at a level for the player, see Level
+    const Mask &cells(Level level, int playerNumber) const { return _cells[level][playerNumber]; }
+    // how many of the player's lines count cell at that level
+    int         count(Level level, int playerNumber, int cell) const { return _cellCounts[level][playerNumber][cell]; }
+
+    //
+    // true if a piece of the player's on cell would make two different winning cells at once, which can't
+    // both be blocked: cell has to be in two of the player's K - 2 lines whose other empty cells differ
+    //
+    bool makesDoubleFour(int cell, int playerNumber) const
+    {
+        if (_cellCounts[kThree][playerNumber][cell] < 2) return false;
+        Mask empty = _board.emptyCells();
+        int winningCell = -1;
+        const auto &lines = Board::kCellLines[cell];
+        for (int i = 0; i < lines.count; i++)
+        {
+            int line = lines.lines[i];
+            if (_lineCounts[1 - playerNumber][line] || _lineCounts[playerNumber][line] != K - 2) continue;
+            for (int other : kLineCells[line])
+            {
+                if (other == cell || !MaskOps::test(empty, other)) continue;
+                if (winningCell < 0) winningCell = other;
+                else if (other != winningCell) return true;
+            }
+        }
+        return false;
+    }
+
+    // the cells in within where the player would make a double four
+    Mask doubleFours(int playerNumber, const Mask &within = Board::kFullMask) const
+    {
+        Mask doubles = {};
+        for (Mask cells = _cells[kThree][playerNumber] & within; cells; cells = MaskOps::withoutLowest(cells))
+        {
+            int cell = MaskOps::lowest(cells);
+            if (makesDoubleFour(cell, playerNumber)) doubles |= MaskOps::bit<Mask>(cell);
+        }
+        return doubles;
+    }
+
+private:
+    // add (sign 1) or take back (sign -1) what the line counts for each player's empty cells
+    void update(int line, int sign)
+    {
+        for (int player = 0; player < 2; player++)
+        {
+            if (_lineCounts[1 - player][line]) continue;
+            int level = K - 1 - _lineCounts[player][line];
+            if (level < 0 || level >= kLevels) continue;
+            for (int cell : kLineCells[line])
+            {
+                if (MaskOps::test(_board.pieces[0] | _board.pieces[1], cell)) continue;
+                uint8_t &count = _cellCounts[level][player][cell];
+                if (sign > 0 && count++ == 0) _cells[level][player] |= MaskOps::bit<Mask>(cell);
+                if (sign < 0 && --count == 0) _cells[level][player] &= ~MaskOps::bit<Mask>(cell);
+            }
+        }
+    }
+
+    Board _board;
+    std::array<std::array<uint8_t, Board::kLines>, 2> _lineCounts;
+    std::array<std::array<std::array<uint8_t, Board::kCells>, 2>, kLevels> _cellCounts;
+    std::array<std::array<Mask, 2>, kLevels> _cells;
+};
@@ -1,5 +1,6 @@
 #include "TicTacToe.h"
 #include "Logger.h"
+#include "SolvedGame.h"
 
 // -----------------------------------------------------------------------------
 // TicTacToe.cpp
@@ -13,6 +14,8 @@
 //  - Players take turns; you can only place into an empty square.
 //  - First player to get three-in-a-row (row, column, or diagonal) wins.
 //  - If all 9 squares are filled and nobody wins, it’s a draw.
+//  - The same code plays the bigger m,n,k games too: a W x H board where K in a
+//    row wins, see MNKGame<W, H, K> (tic tac toe is MNKGame<3, 3, 3>).
 //
 // Notes about the provided engine types you'll use here:
 //  - Bit              : a visual piece (sprite) that belongs to a Player
@@ -30,19 +33,89 @@ const int HUMAN_PLAYER = 0;      // index of the human player (X)
 
 Logger &logger = Logger::GetInstance();
 
-TicTacToe::TicTacToe()
+// only the 3x3 game has a compile-time solved table
+template<int W, int H, int K>
+static constexpr bool kHasSolvedTable = W == 3 && H == 3 && K == 3;
+
+// 4x4 is solved offline instead, see tools/tablebase.cpp
+template<int W, int H, int K>
+static constexpr bool kHasTablebase = W == 4 && H == 4 && K == 4;
+static const char *kTablebasePath = "resources/tablebase_4x4x4.bin";
+static MNKTablebase<4, 4, 4> s_tablebase;
+
+// the boards too big to solve get an opening book, see tools/book.cpp
+template<int W, int H, int K>
+static constexpr bool kHasOpeningBook = !kHasSolvedTable<W, H, K> && !kHasTablebase<W, H, K>;
+template<int W, int H, int K>
+static MNKOpeningBook<W, H, K> s_openingBook;
+
+template<int W, int H, int K>
+static void mapOpeningBook()
 {
+    if (s_openingBook<W, H, K>.isLoaded()) return;
+    std::string path = "resources/book_" + std::to_string(W) + "x" + std::to_string(H) + "x" + std::to_string(K) + ".bin";
+    if (s_openingBook<W, H, K>.load(path))
+    {
+        logger.Info("Mapped " + std::to_string(s_openingBook<W, H, K>.size()) + " opening book positions from " + path);
+    }
+    else logger.Warn("No opening book at " + path + ", run the book tool to make one, those games search from the first move");
 }
 
-TicTacToe::~TicTacToe()
+void MapGameData()
 {
+    if (!s_tablebase.isLoaded())
+    {
+        if (s_tablebase.load(kTablebasePath)) logger.Info(std::string("Mapped the 4x4 tablebase from ") + kTablebasePath);
+        else logger.Warn(std::string("No 4x4 tablebase at ") + kTablebasePath + ", run the tablebase tool to make one, 4x4 games search until then");
+    }
+    mapOpeningBook<7, 6, 4>();
+    mapOpeningBook<15, 15, 5>();
+}
+
+// the threat search finds its wins in far fewer nodes than this, it's only there to stop a runaway
+// (a few microseconds a node on 15x15, so well under a second before the main search gets its turn)
+static constexpr uint64_t kThreatSearchNodes = 200000;
+
+// human replies searched while pondering, the likeliest first; each gets a full AI turn's budget
+static constexpr int kPonderReplies = 4;
+// predicting the likeliest reply gets a quarter of that budget, and if that rounds to nothing
+// (or there's no limit at all) a depth it finishes at quickly on every board instead
+static constexpr int kPonderPredictionDepth = 4;
+
+//
+// the same settings fit every board size: deepen until the time budget runs out
+// the table and book switches start on if MapGameData() found their files
+//
+template<int W, int H, int K>
+MNKGame<W, H, K>::MNKGame()
+{
+    _gameOptions.AIMAXDepth = Board::kCells;
+    _gameOptions.AITimeBudgetMs = 1000;
+    _gameOptions.AIUseSolvedTable = kHasSolvedTable<W, H, K> || (kHasTablebase<W, H, K> && s_tablebase.isLoaded());
+    _gameOptions.AIRunAsync = true;
+    _gameOptions.AIThreads = 0;
+    // tic tac toe has its solved table instead
+    _gameOptions.AIUseThreatSearch = !kHasSolvedTable<W, H, K>;
+    _gameOptions.AIThreatDepth = 8;
+    _gameOptions.AIUseProofSearch = !kHasSolvedTable<W, H, K>;
+    _gameOptions.AIProofNodes = 20000;
+    if constexpr (kHasOpeningBook<W, H, K>) _gameOptions.AIUseOpeningBook = s_openingBook<W, H, K>.isLoaded();
+    // a table lookup is already instant, there's nothing to ponder
+    _gameOptions.AIPonder = !_gameOptions.AIUseSolvedTable;
+}
+
+template<int W, int H, int K>
+MNKGame<W, H, K>::~MNKGame()
+{
+    cancelAISearch();
 }
 
 // -----------------------------------------------------------------------------
 // make an X or an O
 // -----------------------------------------------------------------------------
 // DO NOT CHANGE: This returns a new Bit with the right texture and owner
-Bit* TicTacToe::PieceForPlayer(const int playerNumber)
+template<int W, int H, int K>
+Bit* MNKGame<W, H, K>::PieceForPlayer(const int playerNumber)
 {
     // depending on playerNumber load the "x.png" or the "o.png" graphic
     Bit *bit = new Bit();
@@ -51,23 +124,39 @@ Bit* TicTacToe::PieceForPlayer(const int playerNumber)
     return bit;
 }
 
+//
+// put a new piece for the player into an empty holder, sized to fit the board's squares
+//
+template<int W, int H, int K>
+void MNKGame<W, H, K>::placePiece(BitHolder &holder, int playerNumber)
+{
+    Bit *piece = PieceForPlayer(playerNumber);
+    piece->setSize(kSquareSize, kSquareSize);
+    // position the piece at the holder's position
+    piece->setPosition(holder.getPosition());
+    holder.setBit(piece);
+}
+
 //
 // setup the game board, this is called once at the start of the game
 //
-void TicTacToe::setUpBoard()
+template<int W, int H, int K>
+void MNKGame<W, H, K>::setUpBoard()
 {
     setNumberOfPlayers(2);
     setAIPlayer(AI_PLAYER);
-    _gameOptions.rowX = 3;
-    _gameOptions.rowY = 3;
+    _gameOptions.rowX = W;
+    _gameOptions.rowY = H;
     
     // Fill board with squares
     int xOffset = 25, yOffset = 25;
-    for (int rowX = 0; rowX < _gameOptions.rowX; rowX++) 
+    for (int row = 0; row < H; row++) 
     {
-        for (int rowY = 0; rowY < _gameOptions.rowY; rowY++) 
+        for (int column = 0; column < W; column++) 
         {
-            _grid[rowX][rowY].initHolder(ImVec2(rowX * 100 + xOffset, rowY * 100 + yOffset), "square.png", rowX, rowY);
+            Square &square = _grid[row][column];
+            square.initHolder(ImVec2(column * kSquareSize + xOffset, row * kSquareSize + yOffset), "square.png", column, row);
+            square.setSize(kSquareSize, kSquareSize);
         }
     }
 
@@ -77,7 +166,8 @@ void TicTacToe::setUpBoard()
 //
 // about the only thing we need to actually fill out for tic-tac-toe
 //
-bool TicTacToe::actionForEmptyHolder(BitHolder *holder)
+template<int W, int H, int K>
+bool MNKGame<W, H, K>::actionForEmptyHolder(BitHolder *holder)
 {
     if (_gameOptions.gameOver) return false;
     if (!holder) return false;
@@ -85,20 +175,23 @@ bool TicTacToe::actionForEmptyHolder(BitHolder *holder)
 
     // Place a piece for the current player
     int currentPlayerIndex = getCurrentPlayer()->playerNumber();
-    Bit *piece = PieceForPlayer(currentPlayerIndex);
-    piece->setPosition(holder->getPosition());
-    holder->setBit(piece);
+    placePiece(*holder, currentPlayerIndex);
+    // _grid is laid out in state string order, so the square's offset in it is its cell index
+    _lastMoveCell = (int)(static_cast<Square *>(holder) - &_grid[0][0]);
+    _position.makeMove(_lastMoveCell, currentPlayerIndex);
 
     return true;
 }
 
-bool TicTacToe::canBitMoveFrom(Bit *bit, BitHolder *src)
+template<int W, int H, int K>
+bool MNKGame<W, H, K>::canBitMoveFrom(Bit *bit, BitHolder *src)
 {
     // you can't move anything in tic tac toe
     return false;
 }
 
-bool TicTacToe::canBitMoveFromTo(Bit* bit, BitHolder*src, BitHolder*dst)
+template<int W, int H, int K>
+bool MNKGame<W, H, K>::canBitMoveFromTo(Bit* bit, BitHolder*src, BitHolder*dst)
 {
     // you can't move anything in tic tac toe
     return false;
@@ -107,84 +200,58 @@ bool TicTacToe::canBitMoveFromTo(Bit* bit, BitHolder*src, BitHolder*dst)
 //
 // free all the memory used by the game on the heap
 //
-void TicTacToe::stopGame()
+template<int W, int H, int K>
+void MNKGame<W, H, K>::stopGame()
 {
-    for (int rowX = 0; rowX < _gameOptions.rowX; rowX++) 
+    // The worker may still be searching (or pondering) the old board
+    cancelAISearch();
+    _gameOptions.AIPlaying = false;
+    _ponderStats = PonderStats();
+    _ponderStarted = false;
+
+    for (int row = 0; row < H; row++) 
     {
-        for (int rowY = 0; rowY < _gameOptions.rowY; rowY++) 
+        for (int column = 0; column < W; column++) 
         {
-            _grid[rowX][rowY].destroyBit();
+            _grid[row][column].destroyBit();
         }
     }
+    _lastMoveCell = -1;
+    _position.reset(Board());
     _gameOptions.gameOver = false; // Reset so we can play a new game
 }
 
-//
-// helper function for the winner check
-//
-Player* TicTacToe::ownerAt(int index) const
-{
-    Bit *bit = _grid[index % 3][index / 3].bit();
-    if (!bit) return nullptr;
-    else return bit->getOwner();
-}
-
-Player* TicTacToe::checkForWinner()
+template<int W, int H, int K>
+Player* MNKGame<W, H, K>::checkForWinner()
 {
-    // The winning combinations to check
-    int triples[8][3] = { {0, 1, 2}, {3, 4, 5}, {6, 7, 8}, {0, 3, 6}, {1, 4, 7}, {2, 5, 8}, {0, 4, 8}, {2, 4, 6} };
-
-    // Loop through, checking every combination
-    for (int i = 0; i < 8; i++) {
-        Player *owner1 = ownerAt(triples[i][0]);
-        Player *owner2 = ownerAt(triples[i][1]);
-        Player *owner3 = ownerAt(triples[i][2]);
-        if ((owner1 && owner2 && owner3) && (owner1 == owner2 && owner2 == owner3)) {
-            logger.Event("Player " + std::to_string(owner1->playerNumber()) + " won the game");
-            _gameOptions.gameOver = true;
-            return owner1;
-        }
+    // Only the lines through the piece that was just placed can have been completed this turn
+    Player *winner = checkForWinnerWithGameState(boardState(), _lastMoveCell);
+    if (winner) {
+        logger.Event("Player " + std::to_string(winner->playerNumber()) + " won the game");
+        _gameOptions.gameOver = true;
     }
-    
-    return nullptr;
+    return winner;
 }
 
 //
-// A different winner checking function that using a string game state, rather than the current board (used for AI)
+// A different winner checking function that uses a packed board, rather than the current board
+// Passing the last move played only tests the lines through that cell
 //
-Player* TicTacToe::checkForWinnerWithGameState(std::string gameState) 
+template<int W, int H, int K>
+Player* MNKGame<W, H, K>::checkForWinnerWithGameState(const Board &board, int lastMove) 
 {
-    // The winning combinations to check
-    int triples[8][3] = { {0, 1, 2}, {3, 4, 5}, {6, 7, 8}, {0, 3, 6}, {1, 4, 7}, {2, 5, 8}, {0, 4, 8}, {2, 4, 6} };
-
-    // Loop through, checking every combination
-    for (int i = 0; i < 8; i++)
-    {
-        if (gameState[triples[i][0]] != '0' && gameState[triples[i][1]] != '0' && gameState[triples[i][2]] != '0') 
-        {
-            if (gameState[triples[i][0]] == gameState[triples[i][1]] && gameState[triples[i][1]] == gameState[triples[i][2]])
-            {
-                int playerNumber = gameState[triples[i][0]] == '1' ? 0 : 1;
-                return getPlayerAt(playerNumber);
-            }
-        }
-    }
-
-    return nullptr;
+    int playerNumber = _engines.ai.winner(board, lastMove);
+    if (playerNumber == Board::kNoWinner) return nullptr;
+    return getPlayerAt(playerNumber);
 }
 
-bool TicTacToe::checkForDraw()
+template<int W, int H, int K>
+bool MNKGame<W, H, K>::checkForDraw()
 {
     if (_gameOptions.gameOver) return false;
 
-    for (int rowX = 0; rowX < _gameOptions.rowX; rowX++) 
-    {
-        for (int rowY = 0; rowY < _gameOptions.rowY; rowY++) 
-        {
-            // If any space is open on the board, there is no draw
-            if (!_grid[rowX][rowY].bit()) return false;
-        }
-    }
+    // If any space is open on the board, there is no draw
+    if (!boardState().isFull()) return false;
 
     logger.Event("The game ended in a draw");
     _gameOptions.gameOver = true;
@@ -194,27 +261,29 @@ bool TicTacToe::checkForDraw()
 //
 // state strings
 //
-std::string TicTacToe::initialStateString()
+template<int W, int H, int K>
+std::string MNKGame<W, H, K>::initialStateString()
 {
-    return "000000000";
+    return std::string(Board::kCells, '0');
 }
 
 //
 // this still needs to be tied into imguis init and shutdown
 // we will read the state string and store it in each turn object
 //
-std::string TicTacToe::stateString() const
+template<int W, int H, int K>
+std::string MNKGame<W, H, K>::stateString() const
 {
-    char gameState[] = "000000000";
+    std::string gameState(Board::kCells, '0');
     int stateIndex = 0;
     
-    for (int rowX = 0; rowX < _gameOptions.rowX; rowX++) 
+    for (int row = 0; row < H; row++) 
     {
-        for (int rowY = 0; rowY < _gameOptions.rowY; rowY++) 
+        for (int column = 0; column < W; column++) 
         {
             // for example, to convert an integer to a string, you can use std::to_string(1) which returns "1"
             // you can get the bit at each square using _grid[y][x].bit()
-            Bit *bit = _grid[rowX][rowY].bit();
+            Bit *bit = _grid[row][column].bit();
             // if the bit is not null, you can get its owner using bit->getOwner()->playerNumber()
             // remember that player numbers are zero-based, so add 1 to get '1' or '2'
             if (bit) gameState[stateIndex] = '1' + bit->getOwner()->playerNumber(); // Need to add '1' to convert the player number to the correct character
@@ -227,165 +296,437 @@ std::string TicTacToe::stateString() const
     return gameState;
 }
 
+//
+// the packed version of stateString(), every move is made on _position as its piece is placed
+// so the AI never has to read the grid or build a string
+//
+template<int W, int H, int K>
+typename MNKGame<W, H, K>::Board MNKGame<W, H, K>::boardState() const
+{
+    return _position.board();
+}
+
 //
 // this still needs to be tied into imguis init and shutdown
 // when the program starts it will load the current game from the imgui ini file and set the game state to the last saved state
 //
-void TicTacToe::setStateString(const std::string &s)
+template<int W, int H, int K>
+void MNKGame<W, H, K>::setStateString(const std::string &s)
 {
     // set the state of the board from the given string
-    // the string will be 9 characters long, one for each square
+    // the string will be W * H characters long, one for each square (9 for tic tac toe)
     // each character will be '0' for empty, '1' for player 1 (X), and '2' for player 2 (O)
     // the order will be left-to-right, top-to-bottom
     // for example, the starting state is "000000000"
     // if player 1 has placed an X in the top-left and player 2 an O in the center, the state would be "100020000"
     // you can loop through the string and set each square in _grid accordingly
-    //int stateIndex = 0;
-    //for (int rowX = 0; rowX < _gameOptions.rowX; rowX++) 
-    //{
-    //    for (int rowY = 0; rowY < _gameOptions.rowY; rowY++) 
-    //    {
-            // for example, if s[0] is '1', you would set _grid[0][0] to have player 1's piece
-            // if s[4] is '2', you would set _grid[1][1] to have player 2's piece
-            // if s[8] is '0', you would set _grid[2][2] to be empty
-            // you can use the PieceForPlayer function to create a new piece for a player
+    // there's no telling which piece went down last, so the next winner check scans every line
+    _lastMoveCell = -1;
+    int stateIndex = 0;
+    for (int row = 0; row < H; row++) 
+    {
+        for (int column = 0; column < W; column++) 
+        {
             // remember to convert the character to an integer by subtracting '0'
-            //int playerNumber = s[stateIndex] - '0';
-            // if playerNumber is 0, set the square to empty (nullptr)
+            int playerNumber = stateIndex < (int)s.length() ? s[stateIndex] - '0' : 0;
+            stateIndex++;
+
+            // leave squares that already hold the right piece alone, so restoring a state doesn't reload every texture
+            BitHolder &holder = _grid[row][column];
+            Bit *bit = holder.bit();
+            int currentNumber = bit ? bit->getOwner()->playerNumber() + 1 : 0;
+            if (currentNumber == playerNumber) continue;
+
+            // if playerNumber is 0, set the square to empty
             // if playerNumber is 1 or 2, create a piece for that player and set it in the square
-            //if (playerNumber == 0) _grid[rowX][rowY] = nullptr;
-            //else _grid[rowX][rowY] = PieceForPlayer(s[stateIndex] - '0');
-            //stateIndex++;
+            holder.destroyBit();
+            if (playerNumber == 1 || playerNumber == 2) placePiece(holder, playerNumber - 1);
+        }
+    }
+    _position.reset(Board::fromStateString(s));
+}
 
-            // TODO
-            // finally, make sure to position the piece at the holder's position
-            // you can get the position of a holder using holder->getPosition()
-            // loop through the 3x3 array and set each square accordingly
-            
-    //    }
-    //}
-    // the string should always be valid, so you don't need to check its length or contents
-    // but you can assume it will always be 9 characters long and only contain '0', '1', or '2'
+//
+// Negamax wrapper function to get the best move for the AI player on the current board
+//
+template<int W, int H, int K>
+int MNKGame<W, H, K>::getBestMove() 
+{
+    Board board = boardState();
+    int bestMove = bookMove(board);
+    if (bestMove >= 0) return bestMove;
+    bestMove = runSearch(_engines, board, searchSettings());
+    recordSearch(bestMove, searchStats(), _engines.lastEngine);
+    return bestMove;
 }
 
 //
-// Find all possible moves for the given player
+// the book only holds the AI's positions, so it's asked on the AI's turn and a miss means a search
 //
-std::vector<std::string> TicTacToe::generateMoves(std::string gameState, int playerNumber) 
+template<int W, int H, int K>
+int MNKGame<W, H, K>::bookMove(const Board &board) const
 {
-    // Return state strings for every possible move from the current player's perspective
-    std::vector<std::string> moves;
+    if constexpr (kHasOpeningBook<W, H, K>)
+    {
+        if (!_gameOptions.AIUseOpeningBook) return -1;
+        int bestMove = s_openingBook<W, H, K>.bestMove(board);
+        if (bestMove >= 0) logger.Info("Opening book move: " + std::to_string(bestMove));
+        return bestMove;
+    }
+    return -1;
+}
+
+template<int W, int H, int K>
+uint64_t MNKGame<W, H, K>::openingBookSize() const
+{
+    if constexpr (kHasOpeningBook<W, H, K>) return s_openingBook<W, H, K>.size();
+    return 0;
+}
 
-    for (size_t i = 0; i < gameState.length(); i++)
+template<int W, int H, int K>
+typename MNKGame<W, H, K>::SearchSettings MNKGame<W, H, K>::searchSettings() const
+{
+    return { _gameOptions.AIUseMCTS, _gameOptions.AIUseThreatSearch, _gameOptions.AIUseProofSearch, _gameOptions.AIMAXDepth,
+             _gameOptions.AITimeBudgetMs, _gameOptions.AIThreads, _gameOptions.AIMCTSPlayouts, _gameOptions.AIThreatDepth,
+             _gameOptions.AIProofNodes };
+}
+
+//
+// hand the board to the engine the options picked, safe to call on the worker thread
+// every engine only sees the packed board and these settings, never the game, its Players or the grid
+// a win by threats or a proven win is played straight away, the other engines only get the positions neither finds one in
+//
+template<int W, int H, int K>
+int MNKGame<W, H, K>::runSearch(SearchEngines &engines, const Board &board, const SearchSettings &settings)
+{
+    if (settings.useThreatSearch)
     {
-        if (gameState[i] == '0')
+        const ProofResult &threats = engines.threatSearch.search(board, AI_PLAYER, settings.threatDepth, kThreatSearchNodes);
+        if (threats.outcome == kProofWin && threats.bestMove >= 0)
         {
-            std::string move = gameState;
-            move[i] = '1' + playerNumber;
-            moves.push_back(move);
+            engines.lastEngine = kThreatSearch;
+            return threats.bestMove;
         }
     }
-    
-    return moves;
+    if (settings.useProofSearch)
+    {
+        const ProofResult &proof = engines.proofSearch.solve(board, AI_PLAYER, (uint64_t)settings.proofNodes);
+        if (proof.outcome == kProofWin && proof.bestMove >= 0)
+        {
+            engines.lastEngine = kProofSearch;
+            return proof.bestMove;
+        }
+    }
+    engines.lastEngine = settings.useMCTS ? kMCTS : kNegamax;
+    if (settings.useMCTS) return engines.mcts.searchBestMove(board, AI_PLAYER, settings.playouts, settings.timeBudgetMs, settings.threadCount);
+    return engines.ai.searchBestMove(board, AI_PLAYER, settings.maxDepth, settings.timeBudgetMs, settings.threadCount);
+}
+
+template<int W, int H, int K>
+const SearchStats &MNKGame<W, H, K>::SearchEngines::searchStats() const
+{
+    if (lastEngine == kThreatSearch) return threatSearch.searchStats();
+    if (lastEngine == kProofSearch) return proofSearch.searchStats();
+    return lastEngine == kMCTS ? mcts.searchStats() : ai.searchStats();
+}
+
+template<int W, int H, int K>
+void MNKGame<W, H, K>::SearchEngines::setCancelled(bool cancelled)
+{
+    ai.setCancelled(cancelled);
+    mcts.setCancelled(cancelled);
+    proofSearch.setCancelled(cancelled);
+    threatSearch.setCancelled(cancelled);
+}
+
+template<int W, int H, int K>
+const SearchStats &MNKGame<W, H, K>::searchStats() const
+{
+    return _engines.searchStats();
+}
+
+// the threat and proof searches run on one thread
+template<int W, int H, int K>
+const std::vector<SearchStats> &MNKGame<W, H, K>::threadStats() const
+{
+    static const std::vector<SearchStats> kNoThreadStats;
+    if (_engines.lastEngine == kProofSearch || _engines.lastEngine == kThreatSearch) return kNoThreadStats;
+    return _engines.lastEngine == kMCTS ? _engines.mcts.threadStats() : _engines.ai.threadStats();
 }
 
 //
-// If there's a winner, return 1 if the current player has won, -1 if the opponent won, and 0 if its a draw
+// keep what a search cost for the per-move export, main thread only
 //
-int TicTacToe::evaluate(std::string gameState, int playerNumber) 
+template<int W, int H, int K>
+void MNKGame<W, H, K>::recordSearch(int bestMove, const SearchStats &stats, SearchEngine engine)
 {
-    Player *winner = checkForWinnerWithGameState(gameState);
-    if (winner)
-    {
-        int winnerNumber = winner->playerNumber();
-        if (winnerNumber == playerNumber) return 1;
-        else return -1;
-    }
-    return 0;
+    // only negamax deepens in passes, for the others the deepest node reached is the nearest thing
+    _gameOptions.AIDepthSearches = engine == kNegamax ? stats.completedDepth : stats.maxDepth;
+    _searchRecords.push_back({ _gameNumber, (int)_gameOptions.currentTurnNo, stateString(), bestMove, stats });
+}
+
+template<int W, int H, int K>
+std::vector<int> MNKGame<W, H, K>::principalVariation() const
+{
+    if (_engines.lastEngine != kNegamax) return {};
+    const typename Board::MoveList &line = _engines.ai.principalVariation();
+    return std::vector<int>(line.begin(), line.end());
 }
 
 //
-// Find the most optimal move by evaluating all possible games stemming from that move
+// true while a search is running on the worker thread
 //
-int TicTacToe::negamax(std::string gameState, int depth, int playerNumber)
+template<int W, int H, int K>
+bool MNKGame<W, H, K>::isAIThinking() const
 {
-    if (depth == 0 || checkForWinnerWithGameState(gameState)) return evaluate(gameState, playerNumber);
-    std::vector<std::string> moves = generateMoves(gameState, playerNumber);
-    if (moves.empty()) return 0;
+    return _aiSearch.valid();
+}
 
-    int value = -2;
-    int nextPlayer = playerNumber == 0 ? 1 : 0;
-    for (auto const & move : moves) value = std::max(value, -negamax(move, depth - 1, nextPlayer));
-    return value;
+// a running search in any engine gives up soon after this is set, it stays set until it's cleared
+template<int W, int H, int K>
+void MNKGame<W, H, K>::setSearchesCancelled(bool cancelled)
+{
+    _engines.setCancelled(cancelled);
+    _ponderEngines.setCancelled(cancelled);
 }
 
 //
-// Negamax wrapper function to get the best move for the AI player
+// stop a running background search or ponder and wait for the worker to unwind
 //
-std::string TicTacToe::getBestMove() 
+template<int W, int H, int K>
+void MNKGame<W, H, K>::cancelAISearch()
 {
-    std::string gameState = stateString();
-    std::vector<std::string> moves = generateMoves(gameState, AI_PLAYER);
-    std::string bestMove = "000000000";
-    int bestEvaluation = -2;
+    stopPondering();
+    if (!_aiSearch.valid()) return;
+    setSearchesCancelled(true);
+    _aiSearch.wait();
+    _aiSearch = std::future<int>();
+    setSearchesCancelled(false);
+    logger.Info("Cancelled AI search");
+}
 
-    for (auto const & move : moves) 
+//
+// true until the ponder worker has searched every reply it was going to, or been stopped
+//
+template<int W, int H, int K>
+bool MNKGame<W, H, K>::isPondering() const
+{
+    return _ponder.valid() && _ponder.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+template<int W, int H, int K>
+void MNKGame<W, H, K>::startPondering(const Board &board, const SearchSettings &settings)
+{
+    stopPondering();
+    _ponderStopping = false;
+    _ponderedMoves.clear();
+    _ponderStarted = true;
+    _ponder = std::async(std::launch::async, [this, board, settings]() { ponder(board, settings); });
+}
+
+//
+// the human has moved (or the game is going away), so whatever the ponder worker is on is cut short;
+// the answers it finished stay for takePonderedMove(), and the transposition table keeps everything it saw
+//
+template<int W, int H, int K>
+void MNKGame<W, H, K>::stopPondering()
+{
+    if (!_ponder.valid()) return;
+    _ponderStopping = true;
+    setSearchesCancelled(true);
+    _ponder.wait();
+    _ponder = std::future<void>();
+    setSearchesCancelled(false);
+    _ponderStats.replies = (int)_ponderedMoves.size();
+}
+
+//
+// runs on the ponder worker, the human to move on board
+// the likeliest reply is the one the AI would play in the human's place, found with a short search that also
+// leaves the positions after it in the transposition table; the rest follow in the search's own move order
+// every reply then gets the same search a real AI turn would, on the ponder's own engines, and only finished ones are kept
+//
+template<int W, int H, int K>
+void MNKGame<W, H, K>::ponder(const Board &board, const SearchSettings &settings)
+{
+    MNKAI<W, H, K> &ai = _ponderEngines.ai;
+    int predictionMs = settings.timeBudgetMs / 4;
+    int predictionDepth = settings.maxDepth;
+    if (predictionMs <= 0 && (predictionDepth <= 0 || predictionDepth > kPonderPredictionDepth)) predictionDepth = kPonderPredictionDepth;
+    int predicted = ai.searchBestMove(board, HUMAN_PLAYER, predictionDepth, predictionMs, settings.threadCount);
+    if (_ponderStopping) return;
+
+    typename Board::MoveList replies;
+    if (predicted >= 0) replies.push(predicted);
+    typename Board::Mask moves = ai.generateMoves(board);
+    for (int cell : Board::kMoveOrder)
     {
-        int evaluation = -negamax(move, 9, HUMAN_PLAYER);
-        logger.Info("Checking move: " + move + " Evaluation: " + std::to_string(evaluation));
-        if (evaluation > bestEvaluation) 
-        {
-            bestMove = move;
-            bestEvaluation = evaluation;
-            logger.Event("Chose a new best move: " + bestMove + " Evaluation: " + std::to_string(bestEvaluation));
-        }
+        if (replies.size() >= kPonderReplies) break;
+        if (cell != predicted && MaskOps::test(moves, cell)) replies.push(cell);
     }
 
-    return bestMove;
+    for (int reply : replies)
+    {
+        Board child = board.withMove(reply, HUMAN_PLAYER);
+        if (child.winnerAfterMove(reply) != Board::kNoWinner || child.isFull()) continue;
+        logger.Info("Pondering the reply " + std::to_string(reply));
+        int move = runSearch(_ponderEngines, child, settings);
+        if (_ponderStopping) return;
+        _ponderedMoves.push_back({ child, move, _ponderEngines.searchStats(), _ponderEngines.lastEngine });
+    }
 }
 
+template<int W, int H, int K>
+int MNKGame<W, H, K>::takePonderedMove(const Board &board)
+{
+    // with pondering off there's no hit or miss to count, but a ponder stopped before it finished
+    // any reply still missed
+    if (!_ponderStarted) return -1;
+    _ponderStarted = false;
+    int bestMove = -1;
+    for (const PonderedMove &pondered : _ponderedMoves)
+    {
+        if (pondered.board.pieces[0] != board.pieces[0] || pondered.board.pieces[1] != board.pieces[1]) continue;
+        bestMove = pondered.move;
+        // the move is played like any searched one, so it goes in the export with what the ponder spent on it
+        recordSearch(bestMove, pondered.stats, pondered.engine);
+    }
+    _ponderedMoves.clear();
+    if (bestMove >= 0)
+    {
+        _ponderStats.hits++;
+        logger.Info("Ponder hit, the answer was searched on the human's time");
+    }
+    else _ponderStats.misses++;
+    return bestMove;
+}
 
 //
 // this is the function that will be called by the AI
+// with AIRunAsync the search runs on a worker thread and we poll for its move on later frames,
+// so the render loop keeps going while the AI thinks
 //
-void TicTacToe::updateAI() 
+template<int W, int H, int K>
+void MNKGame<W, H, K>::updateAI() 
 {
-    if (_gameOptions.gameOver) return;
+    if (_gameOptions.gameOver)
+    {
+        // the human's move ended it, there's nothing left to ponder
+        stopPondering();
+        return;
+    }
+
+    if (_aiSearch.valid())
+    {
+        if (_aiSearch.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+        int bestMove = _aiSearch.get();
+        recordSearch(bestMove, searchStats(), _engines.lastEngine);
+        playAIMove(bestMove);
+        return;
+    }
+
     if (_gameOptions.AIPlaying) return;
     else
     {
         _gameOptions.AIPlaying = true;
-
-        std::string bestMove = getBestMove();
-        logger.Info("Best AI move: " + bestMove);
-
-        std::string gameState = stateString();
-        int stateIndex = 0;
-        for (int rowX = 0; rowX < _gameOptions.rowX; rowX++)
+        // the human has moved, anything pondered for this reply is finished now
+        stopPondering();
+
+        // Tic tac toe is solved at compile time and 4x4 is mapped from its tablebase, so the move is a table lookup
+        // Only search if the table is turned off, the board isn't one it knows about or it's a bigger game,
+        // and then only once the opening book (on the bigger games that have one) runs out
+        Board board = boardState();
+        int bestMove = -1;
+        if constexpr (kHasSolvedTable<W, H, K>)
+        {
+            if (_gameOptions.AIUseSolvedTable && SolvedGame::sideToMove(board) == AI_PLAYER) bestMove = SolvedGame::bestMove(board);
+        }
+        else if constexpr (kHasTablebase<W, H, K>)
+        {
+            if (_gameOptions.AIUseSolvedTable && s_tablebase.sideToMove(board) == AI_PLAYER) bestMove = s_tablebase.bestMove(board);
+        }
+        if (bestMove < 0) bestMove = bookMove(board);
+        if (bestMove < 0) bestMove = takePonderedMove(board);
+        if (bestMove < 0)
         {
-            for (int rowY = 0; rowY < _gameOptions.rowY; rowY++)
+            if (_gameOptions.AIRunAsync)
             {
-                // To find the holder for the new move, loop through the board until the place
-                // where the gameState and the bestMove differ
-                if (gameState[stateIndex] != bestMove[stateIndex])
-                {
-                    Square *holder = &_grid[rowX][rowY];
-                    if (actionForEmptyHolder(holder)) 
-                    {
-                        _gameOptions.AIPlaying = false;
-                        endTurn();
-                        logger.Event("AI placed a piece at (" + std::to_string(rowX) + ", " + std::to_string(rowY) + ")");
-
-                    }
-                    else
-                    {
-                        logger.Error("updateAI(): Failed to place piece at (" + std::to_string(rowX) + ", " + std::to_string(rowY) + ")");
-                    }
-                    
-                    return;
-                }
-                stateIndex++;
+                // Snapshot everything the search needs, the worker must not read the grid or options
+                SearchSettings settings = searchSettings();
+                setSearchesCancelled(false);
+                _aiSearch = std::async(std::launch::async, [this, board, settings]() {
+                    return runSearch(_engines, board, settings);
+                });
+                return;
             }
+            bestMove = getBestMove();
         }
+        if constexpr (kHasSolvedTable<W, H, K>) logger.Info("Solved value of this position: " + std::to_string(SolvedGame::value(board)));
+        playAIMove(bestMove);
     }
 }
+
+//
+// place the AI's chosen piece on the board and end its turn
+//
+template<int W, int H, int K>
+void MNKGame<W, H, K>::playAIMove(int bestMove)
+{
+    logger.Info("Best AI move: " + std::to_string(bestMove));
+    if (bestMove < 0)
+    {
+        logger.Error("updateAI(): No legal move to play");
+        _gameOptions.AIPlaying = false;
+        return;
+    }
+
+    // Cell indices follow the state string order, so the holder is at [index / W][index % W]
+    int row = bestMove / W;
+    int column = bestMove % W;
+    Square *holder = &_grid[row][column];
+    if (actionForEmptyHolder(holder)) 
+    {
+        _gameOptions.AIPlaying = false;
+        endTurn();
+        logger.Event("AI placed a piece at (" + std::to_string(column) + ", " + std::to_string(row) + ")");
+        // the human's turn is the AI's idle time
+        _ponderStarted = false;
+        if (_gameOptions.AIPonder && !_gameOptions.gameOver && !_gameOptions.AIvsAI) startPondering(boardState(), searchSettings());
+    }
+    else
+    {
+        logger.Error("updateAI(): Failed to place piece at (" + std::to_string(column) + ", " + std::to_string(row) + ")");
+    }
+}
+
+//
+// the solved table's answer for the current position, tic tac toe and 4x4 (once its tablebase is mapped) only
+//
+template<int W, int H, int K>
+bool MNKGame<W, H, K>::solvedPosition(int &value, int &pliesToEnd, int &bestMove) const
+{
+    if constexpr (kHasSolvedTable<W, H, K>)
+    {
+        Board board = boardState();
+        value = SolvedGame::value(board);
+        pliesToEnd = SolvedGame::pliesToEnd(board);
+        bestMove = SolvedGame::bestMove(board);
+        return true;
+    }
+    else if constexpr (kHasTablebase<W, H, K>)
+    {
+        Board board = boardState();
+        auto probe = s_tablebase.probe(board);
+        if (probe.value == MNKTablebase<W, H, K>::kNotStored) return false;
+        value = probe.value == MNKTablebase<W, H, K>::kWin ? 1 : probe.value == MNKTablebase<W, H, K>::kLoss ? -1 : 0;
+        pliesToEnd = probe.pliesToEnd;
+        bestMove = s_tablebase.bestMove(board);
+        return true;
+    }
+    return false;
+}
+
+template class MNKGame<3, 3, 3>;
+template class MNKGame<4, 4, 4>;
+template class MNKGame<7, 6, 4>;
+template class MNKGame<15, 15, 5>;
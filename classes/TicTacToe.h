@@ -1,27 +1,99 @@
 #pragma once
 #include "Game.h"
 #include "Square.h"
-#include <algorithm>
+#include "TicTacToeBoard.h"
+#include "SearchBoard.h"
+#include "MNKAI.h"
+#include "MNKMCTS.h"
+#include "MNKProofSearch.h"
+#include "MNKThreatSearch.h"
+#include "MNKTablebase.h"
+#include "MNKOpeningBook.h"
+#include "SearchStats.h"
+#include <atomic>
+#include <future>
 #include <vector>
 
 //
-// the classic game of tic tac toe
+// the classic game of tic tac toe, and its bigger m,n,k cousins:
+// a W x H board where the first player to get K in a row wins
 //
 
+//
+// how pondering (searching while the human thinks) has paid off this game
+//
+struct PonderStats
+{
+    int replies = 0;        // human replies the last ponder finished searching the AI's answer to
+    int hits = 0;           // AI turns answered straight from a ponder search
+    int misses = 0;         // AI turns after a ponder where the human's reply wasn't one it finished
+};
+
+//
+// what the application needs from a game without knowing its board size
+//
+class MNKGameBase : public Game
+{
+public:
+    virtual ~MNKGameBase() {}
+
+    virtual int boardWidth() const = 0;
+    virtual int boardHeight() const = 0;
+    virtual int winLength() const = 0;
+    int         cellCount() const { return boardWidth() * boardHeight(); }
+
+    virtual bool isAIThinking() const = 0;
+    virtual void cancelAISearch() = 0;
+    // true while the AI searches on the human's time, with engines of its own so the last turn's stats stay put
+    virtual bool isPondering() const = 0;
+    virtual const PonderStats &ponderStats() const = 0;
+    // what the last search cost, in total and split by search thread
+    virtual const SearchStats &searchStats() const = 0;
+    virtual const std::vector<SearchStats> &threadStats() const = 0;
+    // one record per AI move that needed a search, for exporting with WriteSearchRecords()
+    virtual const std::vector<SearchRecord> &searchRecords() const = 0;
+    virtual const TranspositionTable &transpositionTable() const = 0;
+    // what the proof search made of the last position it was asked about, outcome unknown until then
+    virtual const ProofResult &proofResult() const = 0;
+    // the same for the threat space search that runs before it
+    virtual const ProofResult &threatResult() const = 0;
+    // the line the last negamax search expects, its own move first, and its score; empty after the other engines
+    virtual std::vector<int> principalVariation() const = 0;
+    virtual int principalScore() const = 0;
+    // AI turns whose search picked up where the line of the turn before left off; pondering has its
+    // own negamax, so only the real turns' lines count and are carried over
+    virtual int continuedLines() const = 0;
+
+    // tic tac toe is solved at compile time (see SolvedGame.h), 4x4 by the tablebase tool (see MNKTablebase.h)
+    // fills in the current position's solved value, plies to the end and best move if it is
+    virtual bool solvedPosition(int &value, int &pliesToEnd, int &bestMove) const { return false; }
+    // the bigger boards can have an opening book instead (see MNKOpeningBook.h), 0 positions without one
+    virtual uint64_t openingBookSize() const { return 0; }
+};
+
+// map the tablebase and opening book files the tools wrote, once at startup, every game of that size shares them
+// a missing file is logged and those games search instead
+void MapGameData();
+
 //
 // the main game class
 //
-class TicTacToe : public Game
+template<int W, int H, int K>
+class MNKGame : public MNKGameBase
 {
 public:
-    TicTacToe();
-    ~TicTacToe();
+    using Board = MNKBoard<W, H, K>;
+
+    MNKGame();
+    ~MNKGame();
 
     // set up the board
     void        setUpBoard() override;
 
     Player*     checkForWinner() override;
-    Player*     checkForWinnerWithGameState(std::string gameState);
+    // for the UI, the search asks MNKAI::winner() which doesn't need Players
+    // lastMove is the cell the last piece went into, or -1 to check every line
+    Player*     checkForWinnerWithGameState(const Board &board, int lastMove = -1);
     bool        checkForDraw() override;
     std::string initialStateString() override;
     std::string stateString() const override;
@@ -31,17 +103,116 @@ public:
     bool        canBitMoveFromTo(Bit* bit, BitHolder*src, BitHolder*dst) override;
     void        stopGame() override;
 
-    std::vector<std::string> generateMoves(std::string gameState, int playerNumber);
-    int         evaluate(std::string gameState, int playerNumber);
-    int         negamax(std::string gameState, int depth, int playerNumber);
-    std::string getBestMove();
+    int         boardWidth() const override { return W; }
+    int         boardHeight() const override { return H; }
+    int         winLength() const override { return K; }
+
+    Board       boardState() const;
+    int         getBestMove();
+    bool        isAIThinking() const override;
+    void        cancelAISearch() override;
+    bool        isPondering() const override;
+    const PonderStats &ponderStats() const override { return _ponderStats; }
+    // the searches themselves, they never touch the game
+    MNKAI<W, H, K> &ai() { return _engines.ai; }
+    MNKMCTS<W, H, K> &mcts() { return _engines.mcts; }
+    MNKProofSearch<W, H, K> &proofSearch() { return _engines.proofSearch; }
+    MNKThreatSearch<W, H, K> &threatSearch() { return _engines.threatSearch; }
+    // whichever engine chose the last move
+    const SearchStats &searchStats() const override;
+    const std::vector<SearchStats> &threadStats() const override;
+    const std::vector<SearchRecord> &searchRecords() const override { return _searchRecords; }
+    const TranspositionTable &transpositionTable() const override { return _engines.ai.transpositionTable(); }
+    const ProofResult &proofResult() const override { return _engines.proofSearch.result(); }
+    const ProofResult &threatResult() const override { return _engines.threatSearch.result(); }
+    std::vector<int> principalVariation() const override;
+    int         principalScore() const override { return _engines.ai.principalScore(); }
+    int         continuedLines() const override { return _engines.ai.continuedLines(); }
+    bool        solvedPosition(int &value, int &pliesToEnd, int &bestMove) const override;
+    uint64_t    openingBookSize() const override;
 	void        updateAI() override;
     bool        gameHasAI() override { return true; }
     BitHolder &getHolderAt(const int x, const int y) override { return _grid[y][x]; }
 private:
+    // the squares shrink so every board fits the same 300 pixels
+    static constexpr int kSquareSize = 300 / (W > H ? W : H);
+
+    // one of every engine, and which one chose the last move
+    // the AI's turns and pondering each get a set, so a ponder never moves the MCTS tree, the carried over
+    // principal variation or the results and stats of the turn before it; negamax shares the turns' table
+    enum SearchEngine { kNegamax, kMCTS, kProofSearch, kThreatSearch };
+    struct SearchEngines
+    {
+        MNKAI<W, H, K> ai;
+        MNKMCTS<W, H, K> mcts;
+        MNKProofSearch<W, H, K> proofSearch;
+        MNKThreatSearch<W, H, K> threatSearch;
+        SearchEngine lastEngine = kNegamax;    // set by runSearch(), read once its result is back
+
+        SearchEngines() = default;
+        explicit SearchEngines(std::shared_ptr<TranspositionTable> transpositionTable) : ai(std::move(transpositionTable)) {}
+        const SearchStats &searchStats() const;
+        void        setCancelled(bool cancelled);
+    };
+
     Bit *       PieceForPlayer(const int playerNumber);
-    Player*     ownerAt(int index ) const;
+    void        placePiece(BitHolder &holder, int playerNumber);
+    void        playAIMove(int bestMove);
+    void        recordSearch(int bestMove, const SearchStats &stats, SearchEngine engine);
+    // the opening book's move if it's turned on and has one, -1 otherwise
+    int         bookMove(const Board &board) const;
+
+    // the options a search reads, copied on the main thread so the worker never touches _gameOptions
+    struct SearchSettings
+    {
+        bool useMCTS;
+        bool useThreatSearch;
+        bool useProofSearch;
+        int  maxDepth;
+        int  timeBudgetMs;
+        int  threadCount;
+        int  playouts;
+        int  threatDepth;
+        int  proofNodes;
+    };
+    SearchSettings searchSettings() const;
+    int         runSearch(SearchEngines &engines, const Board &board, const SearchSettings &settings);
 
-    Square      _grid[3][3];
+    // pondering: once the AI has moved, search its answers to the human's likeliest replies on the
+    // human's time, then play a finished answer straight away if the human picks that reply
+    void        startPondering(const Board &board, const SearchSettings &settings);
+    void        stopPondering();
+    void        ponder(const Board &board, const SearchSettings &settings);
+    // the finished answer to the reply the human played, -1 if it wasn't pondered; counts the hit or miss
+    int         takePonderedMove(const Board &board);
+    void        setSearchesCancelled(bool cancelled);
+
+    Square      _grid[H][W];            // [row][column], so a cell index is row * W + column
+    int         _lastMoveCell = -1;     // cell of the last piece placed, so checkForWinner() only tests its lines
+    SearchBoard<W, H, K> _position;     // the grid's pieces, packed, moves are made on it as they're played
+    SearchEngines _engines;
+    SearchEngines _ponderEngines { _engines.ai.sharedTranspositionTable() };
+    std::vector<SearchRecord> _searchRecords;
+    std::future<int>  _aiSearch;            // the background search, valid while the AI is thinking
+
+    struct PonderedMove
+    {
+        Board board;                        // the position after the human's reply
+        int   move;                         // the AI's answer to it
+        SearchStats stats;                  // and what finding it cost, recorded if it's played
+        SearchEngine engine;
+    };
+    std::future<void> _ponder;              // valid from the AI's move until the human's, may finish early
+    std::atomic<bool> _ponderStopping { false };
+    std::vector<PonderedMove> _ponderedMoves;   // filled by the ponder worker, read once it has stopped
+    bool        _ponderStarted = false;             // a ponder ran on the human's time since the AI last moved
+    PonderStats _ponderStats;
 };
 
+// the board sizes the game offers, built once in TicTacToe.cpp
+extern template class MNKGame<3, 3, 3>;
+extern template class MNKGame<4, 4, 4>;
+extern template class MNKGame<7, 6, 4>;
+extern template class MNKGame<15, 15, 5>;
+
+using TicTacToe = MNKGame<3, 3, 3>;
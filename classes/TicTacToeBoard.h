@@ -0,0 +1,17 @@
+#pragma once
+#include "MNKBoard.h"
+
+//
+// packed tic tac toe position used by the AI search, the 3x3, three in a row m,n,k board
+// each player gets a 9-bit occupancy mask, bit i is cell i of the state string
+//
+using TicTacToeBoard = MNKBoard<3, 3, 3>;
+
+// the generated tables have to match the hand written ones the game started out with
+static_assert(TicTacToeBoard::kStates == 19683);
+static_assert(TicTacToeBoard::kFullMask == 0x1FF);
+static_assert(TicTacToeBoard::kLines == 8);
+static_assert(TicTacToeBoard::kWinMasks[0] == 0b000000111 && TicTacToeBoard::kWinMasks[3] == 0b001001001
+              && TicTacToeBoard::kWinMasks[6] == 0b100010001 && TicTacToeBoard::kWinMasks[7] == 0b001010100);
+static_assert(TicTacToeBoard::kCellLines[4].count == 4 && TicTacToeBoard::kCellLines[1].count == 2);
+static_assert(TicTacToeBoard::kMoveOrder == std::array<uint8_t, 9> { 4, 0, 2, 6, 8, 1, 3, 5, 7 });
@@ -0,0 +1,80 @@
+#include "TranspositionTable.h"
+
+TranspositionTable::TranspositionTable(int sizeBits) :
+    _mask((uint64_t(1) << sizeBits) - 1),
+    _entries(new std::atomic<uint64_t>[size_t(1) << sizeBits])
+{
+    clear();
+}
+
+//
+// two bytes of score, a byte each for depth, bestMove and bound plus the side to move, and the top
+// 29 bits of the key as a check, which is every bit the entry leaves spare
+// a packed word of 0 is an empty slot since kBoundNone is 0
+//
+static constexpr int kCheckShift = 35;
+
+uint64_t TranspositionTable::pack(uint64_t key, const TTEntry &entry)
+{
+    return (uint64_t)(uint16_t)entry.score
+         | (uint64_t)entry.depth << 16
+         | (uint64_t)(uint8_t)entry.bestMove << 24
+         | (uint64_t)(entry.bound | entry.playerNumber << 2) << 32
+         | (key >> kCheckShift) << kCheckShift;
+}
+
+TTEntry TranspositionTable::unpack(uint64_t bits)
+{
+    TTEntry entry;
+    entry.score = (int16_t)(bits & 0xFFFF);
+    entry.depth = (uint8_t)((bits >> 16) & 0xFF);
+    entry.bestMove = (int16_t)((bits >> 24) & 0xFF);
+    if (entry.bestMove == 0xFF) entry.bestMove = -1;
+    entry.bound = (uint8_t)((bits >> 32) & 0x3);
+    entry.playerNumber = (uint8_t)((bits >> 34) & 0x1);
+    return entry;
+}
+
+bool TranspositionTable::probe(uint64_t key, int playerNumber, TTEntry &entry) const
+{
+    uint64_t bits = _entries[key & _mask].load(std::memory_order_relaxed);
+    if (bits >> kCheckShift != key >> kCheckShift) return false;
+    TTEntry slot = unpack(bits);
+    if (slot.bound == kBoundNone || slot.playerNumber != playerNumber) return false;
+    entry = slot;
+    return true;
+}
+
+//
+// a deeper result for the same position keeps its slot, so a shallow pass of iterative deepening
+// can't replace a position that an earlier turn already searched further; the search uses a deeper
+// entry only once its score is proven and otherwise just takes its move (see negamax)
+// a different position that lands in the same slot always replaces it
+//
+void TranspositionTable::store(uint64_t key, int playerNumber, int depth, int score, TTBound bound, int bestMove)
+{
+    std::atomic<uint64_t> &slot = _entries[key & _mask];
+
+    uint64_t previous = slot.load(std::memory_order_relaxed);
+    if (previous != 0 && previous >> kCheckShift == key >> kCheckShift)
+    {
+        TTEntry existing = unpack(previous);
+        if (existing.playerNumber == playerNumber && existing.depth > depth) return;
+    }
+
+    TTEntry entry;
+    entry.score = (int16_t)score;
+    entry.depth = (uint8_t)depth;
+    entry.bestMove = (int16_t)bestMove;
+    entry.bound = bound;
+    entry.playerNumber = (uint8_t)playerNumber;
+
+    // Another thread can slip in between the load and the store, either entry is a valid result
+    if (slot.exchange(pack(key, entry), std::memory_order_relaxed) == 0) _usedEntries.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear()
+{
+    for (uint64_t i = 0; i <= _mask; i++) _entries[i].store(0, std::memory_order_relaxed);
+    _usedEntries = 0;
+}
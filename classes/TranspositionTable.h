@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+//
+// remembers the result of every position the search has already solved
+// positions come in as the key of their canonical image (see SearchBoard::canonicalKey()), so all
+// symmetric images share one slot; the low bits of the key pick the slot and the top 29 bits are
+// kept to tell positions that land in the same slot apart
+// a 3x3 board's key is its ternary index, so with 2^15 slots tic tac toe never has a collision
+// slots are packed into single atomic words, so parallel search threads can share
+// the table without locks and never read a half-written entry
+//
+
+enum TTBound : uint8_t
+{
+    kBoundNone,             // empty slot
+    kBoundExact,            // score is the true value at this depth
+    kBoundLower,            // search failed high, true value is at least score
+    kBoundUpper             // search failed low, true value is at most score
+};
+
+struct TTEntry
+{
+    int16_t score;
+    uint8_t depth;
+    int16_t bestMove;       // cell index in the canonical image's frame, or -1
+    uint8_t bound;
+    uint8_t playerNumber;   // side to move when the entry was stored
+};
+
+class TranspositionTable
+{
+public:
+    // the table has 2^sizeBits slots
+    explicit TranspositionTable(int sizeBits);
+
+    // fills entry and returns true if this position was stored for the same side to move
+    bool        probe(uint64_t key, int playerNumber, TTEntry &entry) const;
+    void        store(uint64_t key, int playerNumber, int depth, int score, TTBound bound, int bestMove);
+    void        clear();
+
+    // hits and misses are counted per search thread in SearchStats
+    int         usedEntries() const { return _usedEntries.load(std::memory_order_relaxed); }
+    int         size() const { return (int)_mask + 1; }
+
+private:
+    static uint64_t pack(uint64_t key, const TTEntry &entry);
+    static TTEntry  unpack(uint64_t bits);
+
+    uint64_t                                _mask;
+    std::unique_ptr<std::atomic<uint64_t>[]> _entries;
+    std::atomic<int>                        _usedEntries;
+};
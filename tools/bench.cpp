@@ -0,0 +1,409 @@
+//
+// bench: times the engine's hot paths over a fixed corpus of positions
+//
+// Each benchmark runs some warmup samples that are thrown away, then a number of timed samples.
+// A sample runs the operation over the whole corpus, and the results are reported per operation
+// (median, p99, mean and fastest, in nanoseconds) so runs on different machines or builds can be
+// compared directly. --json writes the same numbers out for scripts to diff.
+// Every heap allocation made while a sample runs is counted too, the search itself should make none.
+//
+// usage: bench [--samples N] [--warmup N] [--filter text] [--json file]
+//
+#include "../classes/TicTacToe.h"
+#include "../classes/Logger.h"
+#include "../Application.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+//
+// the game calls back into the application at the end of every turn,
+// there's no window here so there's nothing to do
+//
+namespace ClassGame {
+    void EndOfTurn() {}
+}
+
+// results land here so the compiler can't throw the work away
+static volatile uint64_t g_sink = 0;
+
+//
+// every operator new in the program goes through here, so the benchmarks can count allocations
+//
+static std::atomic<uint64_t> g_allocations { 0 };
+
+void *operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+
+struct BenchOptions
+{
+    int         samples = 100;
+    int         warmup = 10;
+    std::string filter;
+    std::string jsonPath;
+};
+
+struct BenchResult
+{
+    std::string name;
+    int         opsPerSample = 0;
+    double      medianNs = 0.0;
+    double      p99Ns = 0.0;
+    double      meanNs = 0.0;
+    double      minNs = 0.0;
+    double      allocationsPerOp = 0.0;
+};
+
+//
+// times run() for every sample and returns the per-operation numbers
+// setup() runs before each sample and isn't timed, it puts the state back the way run() expects it
+//
+template<class Setup, class Run>
+static void runBench(const BenchOptions &options, std::vector<BenchResult> &results, const std::string &name,
+                     int opsPerSample, Setup &&setup, Run &&run)
+{
+    if (!options.filter.empty() && name.find(options.filter) == std::string::npos) return;
+
+    for (int i = 0; i < options.warmup; i++)
+    {
+        setup();
+        run();
+    }
+
+    std::vector<double> samples;
+    samples.reserve(options.samples);
+    uint64_t allocations = 0;
+    for (int i = 0; i < options.samples; i++)
+    {
+        setup();
+        uint64_t allocationsBefore = g_allocations.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        run();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        allocations += g_allocations.load(std::memory_order_relaxed) - allocationsBefore;
+        samples.push_back(ns / opsPerSample);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    BenchResult result;
+    result.name = name;
+    result.opsPerSample = opsPerSample;
+    result.medianNs = samples.size() % 2 ? samples[samples.size() / 2]
+                                         : (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2.0;
+    result.p99Ns = samples[std::min(samples.size() - 1, (size_t)(samples.size() * 0.99))];
+    double total = 0.0;
+    for (double sample : samples) total += sample;
+    result.meanNs = total / samples.size();
+    result.minNs = samples.front();
+    result.allocationsPerOp = (double)allocations / ((double)options.samples * opsPerSample);
+
+    std::printf("%-28s %10.1f %10.1f %10.1f %10.1f %10.2f %8d\n", result.name.c_str(),
+                result.medianNs, result.p99Ns, result.meanNs, result.minNs, result.allocationsPerOp, result.opsPerSample);
+    results.push_back(result);
+}
+
+template<class Run>
+static void runBench(const BenchOptions &options, std::vector<BenchResult> &results, const std::string &name,
+                     int opsPerSample, Run &&run)
+{
+    runBench(options, results, name, opsPerSample, []() {}, std::forward<Run>(run));
+}
+
+//
+// every position that can come up in a real game, in ternary index order so the corpus is
+// the same on every run
+//
+static std::vector<TicTacToeBoard> reachablePositions()
+{
+    std::set<int> seen;
+    std::vector<TicTacToeBoard> frontier = { TicTacToeBoard() };
+    seen.insert(0);
+    for (int ply = 0; ply < TicTacToeBoard::kCells && !frontier.empty(); ply++)
+    {
+        std::vector<TicTacToeBoard> next;
+        for (const TicTacToeBoard &board : frontier)
+        {
+            if (board.winner() >= 0) continue;
+            uint16_t moves = board.emptyCells();
+            while (moves)
+            {
+                int cell = std::countr_zero(moves);
+                moves &= moves - 1;
+                TicTacToeBoard child = board.withMove(cell, ply % 2);
+                if (seen.insert(child.ternaryIndex()).second) next.push_back(child);
+            }
+        }
+        frontier = std::move(next);
+    }
+
+    std::vector<TicTacToeBoard> positions;
+    for (int index : seen) positions.push_back(TicTacToeBoard::fromTernaryIndex(index));
+    return positions;
+}
+
+//
+// positions for the search benchmarks, from the opening to a few moves from the end
+//
+static const char *kSearchCorpus[] = {
+    "000000000",    // empty board
+    "000010000",    // X center
+    "100000000",    // X corner
+    "010000000",    // X edge
+    "100020000",    // X corner, O center
+    "000010002",    // X center, O corner
+    "100020001",    // opposite corners against the center
+    "120010000",    // X threatens the diagonal
+    "112020000",    // O threatens the diagonal
+    "102010200",
+    "121020100",
+    "121212000",
+};
+
+static void writeJson(const BenchOptions &options, const std::vector<BenchResult> &results)
+{
+    std::ofstream file(options.jsonPath);
+    if (!file)
+    {
+        std::fprintf(stderr, "bench: can't write %s\n", options.jsonPath.c_str());
+        return;
+    }
+    file << "{\n";
+    file << "  \"samples\": " << options.samples << ",\n";
+    file << "  \"warmup\": " << options.warmup << ",\n";
+    file << "  \"unit\": \"ns/op\",\n";
+    file << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult &result = results[i];
+        file << "    { \"name\": \"" << result.name << "\""
+             << ", \"opsPerSample\": " << result.opsPerSample
+             << ", \"median\": " << result.medianNs
+             << ", \"p99\": " << result.p99Ns
+             << ", \"mean\": " << result.meanNs
+             << ", \"min\": " << result.minNs
+             << ", \"allocationsPerOp\": " << result.allocationsPerOp
+             << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n";
+    file << "}\n";
+}
+
+static bool parseOptions(int argc, char **argv, BenchOptions &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--samples") && hasValue) options.samples = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--warmup") && hasValue) options.warmup = std::max(0, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--filter") && hasValue) options.filter = argv[++i];
+        else if (!std::strcmp(argv[i], "--json") && hasValue) options.jsonPath = argv[++i];
+        else
+        {
+            std::fprintf(stderr, "usage: bench [--samples N] [--warmup N] [--filter text] [--json file]\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) return EXIT_FAILURE;
+
+    // the search benchmarks run on a bare TicTacToeAI, the game is only there for the UI-side calls
+    TicTacToe game;
+    game.setUpBoard();
+    TicTacToeAI ai;
+    MNKMCTS<3, 3, 3> mcts;
+    MNKProofSearch<3, 3, 3> proofSearch;
+    MNKThreatSearch<3, 3, 3> threatSearch;
+
+    const std::vector<TicTacToeBoard> positions = reachablePositions();
+    std::vector<TicTacToeBoard> searchPositions;
+    std::vector<std::string> searchStates;
+    for (const char *state : kSearchCorpus)
+    {
+        searchPositions.push_back(TicTacToeBoard::fromStateString(state));
+        searchStates.push_back(state);
+    }
+    const int positionCount = (int)positions.size();
+    const int searchCount = (int)searchPositions.size();
+
+    std::vector<BenchResult> results;
+    std::printf("%-28s %10s %10s %10s %10s %10s %8s\n", "ns/op", "median", "p99", "mean", "min", "allocs/op", "ops");
+
+    runBench(options, results, "checkForWinnerWithGameState", positionCount, [&]()
+    {
+        uint64_t winners = 0;
+        for (const TicTacToeBoard &board : positions) winners += game.checkForWinnerWithGameState(board) != nullptr;
+        g_sink = g_sink + winners;
+    });
+
+    runBench(options, results, "winner", positionCount, [&]()
+    {
+        uint64_t winners = 0;
+        for (const TicTacToeBoard &board : positions) winners += ai.winner(board) != TicTacToeBoard::kNoWinner;
+        g_sink = g_sink + winners;
+    });
+
+    runBench(options, results, "generateMoves", positionCount, [&]()
+    {
+        uint64_t moves = 0;
+        for (const TicTacToeBoard &board : positions) moves += ai.generateMoves(board);
+        g_sink = g_sink + moves;
+    });
+
+    runBench(options, results, "evaluate", positionCount, [&]()
+    {
+        int64_t score = 0;
+        for (const TicTacToeBoard &board : positions) score += ai.evaluate(board, board.pieceCount() % 2);
+        g_sink = g_sink + (uint64_t)score;
+    });
+
+    // the table is cleared before every sample so each one searches the same number of nodes
+    for (int depth : { 1, 3, 5, 9 })
+    {
+        runBench(options, results, "negamax depth " + std::to_string(depth), searchCount,
+            [&]() { ai.clearTranspositionTable(); },
+            [&]()
+            {
+                int64_t score = 0;
+                for (const TicTacToeBoard &board : searchPositions)
+                {
+                    TicTacToeAI::Position searchBoard(board);
+                    score += ai.negamax(searchBoard, depth, -TicTacToeAI::kInfinity, TicTacToeAI::kInfinity, board.pieceCount() % 2);
+                }
+                g_sink = g_sink + (uint64_t)score;
+            });
+    }
+
+    // the whole AI turn on one thread: iterative deepening, root move dedup and the per-depth bookkeeping
+    // the log lines written once it's done are the only allocations it should make
+    runBench(options, results, "searchBestMove", searchCount,
+        [&]()
+        {
+            ai.clearTranspositionTable();
+            Logger::GetInstance().Clear();
+        },
+        [&]()
+        {
+            int64_t moves = 0;
+            for (const TicTacToeBoard &board : searchPositions) moves += ai.searchBestMove(board, board.pieceCount() % 2, 0, 0, 1);
+            g_sink = g_sink + (uint64_t)moves;
+        });
+    Logger::GetInstance().Clear();
+
+    // settles every corpus position outright, compare with searchBestMove above
+    runBench(options, results, "proofSearch solve", searchCount,
+        [&]()
+        {
+            proofSearch.clearTable();
+            Logger::GetInstance().Clear();
+        },
+        [&]()
+        {
+            uint64_t outcomes = 0;
+            for (const TicTacToeBoard &board : searchPositions) outcomes += proofSearch.solve(board, board.pieceCount() % 2, 1000000).outcome;
+            g_sink = g_sink + outcomes;
+        });
+    Logger::GetInstance().Clear();
+
+    // fours and threes only, as it runs ahead of the main search on every AI turn
+    runBench(options, results, "threatSearch search", searchCount,
+        [&]() { Logger::GetInstance().Clear(); },
+        [&]()
+        {
+            uint64_t outcomes = 0;
+            for (const TicTacToeBoard &board : searchPositions)
+            {
+                outcomes += threatSearch.search(board, board.pieceCount() % 2, MNKThreatSearch<3, 3, 3>::kMaxThreats, 1000000).outcome;
+            }
+            g_sink = g_sink + outcomes;
+        });
+    Logger::GetInstance().Clear();
+
+    // timed per playout; the arenas are taken by the warmup samples, so the tree itself should allocate nothing
+    constexpr int kPlayouts = 1000;
+    runBench(options, results, "mcts playout", searchCount * kPlayouts,
+        [&]()
+        {
+            mcts.clearTree();
+            Logger::GetInstance().Clear();
+        },
+        [&]()
+        {
+            int64_t moves = 0;
+            for (const TicTacToeBoard &board : searchPositions) moves += mcts.searchBestMove(board, board.pieceCount() % 2, kPlayouts, 0);
+            g_sink = g_sink + (uint64_t)moves;
+        });
+    Logger::GetInstance().Clear();
+
+    // the same search on 1 to N threads sharing one tree, on a board big enough that the playouts
+    // don't all pile into a few nodes; the speedup is how well the tree parallelizes
+    MNKMCTS<7, 6, 4> bigMCTS;
+    const MNKBoard<7, 6, 4> emptyBoard;
+    constexpr int kScalingPlayouts = 10000;
+    std::vector<int> threadCounts;
+    int hardwareThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    for (int threads = 1; threads < hardwareThreads; threads *= 2) threadCounts.push_back(threads);
+    threadCounts.push_back(hardwareThreads);
+    std::vector<std::pair<int, double>> scaling;
+    for (int threads : threadCounts)
+    {
+        size_t before = results.size();
+        runBench(options, results, "mcts 7x6x4 " + std::to_string(threads) + " threads", kScalingPlayouts,
+            [&]()
+            {
+                bigMCTS.clearTree();
+                Logger::GetInstance().Clear();
+            },
+            [&]() { g_sink = g_sink + (uint64_t)bigMCTS.searchBestMove(emptyBoard, 0, kScalingPlayouts, 0, threads); });
+        if (results.size() > before) scaling.push_back({ threads, 1e9 / results.back().medianNs });
+    }
+    Logger::GetInstance().Clear();
+    for (const auto &[threads, playoutsPerSecond] : scaling)
+    {
+        std::printf("  %2d threads: %12.0f playouts/s  %5.2fx\n", threads, playoutsPerSecond, playoutsPerSecond / scaling.front().second);
+    }
+
+    runBench(options, results, "stateString", 100,
+        [&]() { game.setStateString(searchStates[searchCount - 1]); },
+        [&]()
+        {
+            uint64_t length = 0;
+            for (int i = 0; i < 100; i++) length += game.stateString().length();
+            g_sink = g_sink + length;
+        });
+
+    // stepping through the corpus changes a few squares each time, like restoring a saved game
+    runBench(options, results, "setStateString", searchCount, [&]()
+    {
+        for (const std::string &state : searchStates) game.setStateString(state);
+    });
+
+    // every sample starts back at the first turn, so each one pushes the same 1000 turns
+    game.setStateString(searchStates[0]);
+    runBench(options, results, "Game::endTurn", 1000,
+        [&]() { game.resetTurns(); },
+        [&]() { for (int i = 0; i < 1000; i++) game.endTurn(); });
+
+    if (!options.jsonPath.empty()) writeJson(options, results);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,68 @@
+//
+// book: builds the opening book the game maps at startup for a board too big to solve outright
+//
+// Every position the book side can face in the first few plies gets a full AI search, spread across a
+// ThreadPool, and the moves it picks are written out sorted by canonical key (see MNKOpeningBook.h).
+// Run it from the directory the game runs in, the game looks for resources/book_<board>.bin.
+//
+// usage: book <7x6x4|15x15x5> [plies] [ms per position] [threads] [output file]
+//        plies defaults to 4, the time to 1000 ms and threads to one per hardware thread
+//
+#include "../classes/MNKOpeningBook.h"
+#include "../classes/Logger.h"
+#include "../classes/ThreadPool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+// the AI is always the second player in the game
+static constexpr int kBookPlayer = 1;
+
+template<int W, int H, int K>
+static int buildBook(const std::string &name, int argc, char **argv)
+{
+    using Book = MNKOpeningBook<W, H, K>;
+    typename Book::BuildSettings settings;
+    settings.bookPlayer = kBookPlayer;
+    if (argc > 2) settings.plies = std::max(1, std::atoi(argv[2]));
+    if (argc > 3) settings.timeBudgetMs = std::max(1, std::atoi(argv[3]));
+    int threads = argc > 4 ? std::max(0, std::atoi(argv[4])) : 0;
+    std::string path = argc > 5 ? argv[5] : "resources/book_" + name + ".bin";
+
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent);
+
+    ThreadPool pool((unsigned int)threads);
+    auto start = std::chrono::steady_clock::now();
+    bool written = Book::build(path, pool, settings);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    // every search logs a few lines, nobody is going to read them here
+    Logger::GetInstance().Clear();
+    if (!written)
+    {
+        std::printf("couldn't write %s\n", path.c_str());
+        return EXIT_FAILURE;
+    }
+
+    Book book;
+    if (!book.load(path))
+    {
+        std::printf("couldn't map %s back in\n", path.c_str());
+        return EXIT_FAILURE;
+    }
+    std::printf("%s book       %llu positions, %d plies, %d ms each, %.1f s on %u threads\n", name.c_str(),
+                (unsigned long long)book.size(), settings.plies, settings.timeBudgetMs, seconds, pool.size());
+    std::printf("written to       %s (%llu bytes)\n", path.c_str(), (unsigned long long)std::filesystem::file_size(path));
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    std::string board = argc > 1 ? argv[1] : "";
+    if (board == "7x6x4") return buildBook<7, 6, 4>(board, argc, argv);
+    if (board == "15x15x5") return buildBook<15, 15, 5>(board, argc, argv);
+    std::printf("usage: book <7x6x4|15x15x5> [plies] [ms per position] [threads] [output file]\n");
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,194 @@
+//
+// perft: walks the whole tic tac toe game tree and counts what it finds
+//
+// Every game ends after the same fixed set of move sequences, so the totals never change
+// (255168 games, 5478 reachable positions of which 958 are terminal) and the time it takes
+// is a reproducible throughput number for the move generator and win check the AI uses.
+// Runs once on a single thread, then again with the root split across a ThreadPool.
+//
+// usage: perft [iterations] [threads]      threads 0 (the default) means one per hardware thread
+//
+#include "../classes/TicTacToeBoard.h"
+#include "../classes/ThreadPool.h"
+#include <bitset>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <vector>
+
+static constexpr uint64_t kExpectedGames      = 255168;
+static constexpr uint64_t kExpectedPositions  = 5478;
+static constexpr uint64_t kExpectedTerminals  = 958;
+
+// plies played before the tree is handed out to the pool, 9 * 8 = 72 subtrees
+static constexpr int kSplitPly = 2;
+
+struct PerftCounts
+{
+    uint64_t nodes = 0;                 // positions visited, counting transpositions every time
+    uint64_t games = 0;                 // move sequences that end the game
+    uint64_t wins[2] = { 0, 0 };
+    uint64_t draws = 0;
+    uint64_t gamesAtPly[TicTacToeBoard::kCells + 1] = {};
+    std::bitset<TicTacToeBoard::kStates> positions;     // every distinct board seen, by ternary index
+    std::bitset<TicTacToeBoard::kStates> terminals;
+
+    PerftCounts &operator+=(const PerftCounts &other)
+    {
+        nodes += other.nodes;
+        games += other.games;
+        wins[0] += other.wins[0];
+        wins[1] += other.wins[1];
+        draws += other.draws;
+        for (int ply = 0; ply <= TicTacToeBoard::kCells; ply++) gamesAtPly[ply] += other.gamesAtPly[ply];
+        positions |= other.positions;
+        terminals |= other.terminals;
+        return *this;
+    }
+};
+
+//
+// the same two questions the AI asks at every node: did the last move win, and which cells are empty
+//
+static void walk(const TicTacToeBoard &board, int playerNumber, int ply, int lastMove, PerftCounts &counts)
+{
+    counts.nodes++;
+    int index = board.ternaryIndex();
+    counts.positions.set(index);
+
+    int winner = board.winnerAfterMove(lastMove);
+    uint16_t moves = board.emptyCells();
+    if (winner >= 0 || !moves)
+    {
+        counts.games++;
+        counts.gamesAtPly[ply]++;
+        counts.terminals.set(index);
+        if (winner >= 0) counts.wins[winner]++;
+        else counts.draws++;
+        return;
+    }
+
+    while (moves)
+    {
+        int cell = std::countr_zero(moves);
+        moves &= moves - 1;
+        walk(board.withMove(cell, playerNumber), 1 - playerNumber, ply + 1, cell, counts);
+    }
+}
+
+//
+// walks the first kSplitPly plies like walk() does and collects the boards below them,
+// nobody can have won that early so every one of them is still in play
+//
+static void splitTree(const TicTacToeBoard &board, int playerNumber, int ply, PerftCounts &counts, std::vector<TicTacToeBoard> &boards)
+{
+    if (ply == kSplitPly)
+    {
+        boards.push_back(board);
+        return;
+    }
+    counts.nodes++;
+    counts.positions.set(board.ternaryIndex());
+
+    uint16_t moves = board.emptyCells();
+    while (moves)
+    {
+        int cell = std::countr_zero(moves);
+        moves &= moves - 1;
+        splitTree(board.withMove(cell, playerNumber), 1 - playerNumber, ply + 1, counts, boards);
+    }
+}
+
+static PerftCounts perftSingle()
+{
+    PerftCounts counts;
+    walk(TicTacToeBoard(), 0, 0, -1, counts);
+    return counts;
+}
+
+static PerftCounts perftParallel(ThreadPool &pool)
+{
+    PerftCounts counts;
+    std::vector<TicTacToeBoard> boards;
+    splitTree(TicTacToeBoard(), 0, 0, counts, boards);
+
+    // one task per pool thread, each walking every size()-th subtree
+    unsigned int lanes = pool.size();
+    std::vector<std::future<PerftCounts>> results;
+    for (unsigned int lane = 0; lane < lanes; lane++)
+    {
+        results.push_back(pool.submit([&boards, lane, lanes]()
+        {
+            PerftCounts laneCounts;
+            for (size_t i = lane; i < boards.size(); i += lanes)
+            {
+                walk(boards[i], kSplitPly % 2, kSplitPly, -1, laneCounts);
+            }
+            return laneCounts;
+        }));
+    }
+    for (auto &result : results) counts += result.get();
+    return counts;
+}
+
+static bool report(const char *label, const PerftCounts &counts, double bestMs, double totalMs, int iterations)
+{
+    bool correct = counts.games == kExpectedGames
+                && counts.positions.count() == kExpectedPositions
+                && counts.terminals.count() == kExpectedTerminals;
+
+    std::printf("%s\n", label);
+    std::printf("  games           %llu\n", (unsigned long long)counts.games);
+    std::printf("  X wins          %llu\n", (unsigned long long)counts.wins[0]);
+    std::printf("  O wins          %llu\n", (unsigned long long)counts.wins[1]);
+    std::printf("  draws           %llu\n", (unsigned long long)counts.draws);
+    std::printf("  games by ply   ");
+    for (int ply = 0; ply <= TicTacToeBoard::kCells; ply++) std::printf(" %llu", (unsigned long long)counts.gamesAtPly[ply]);
+    std::printf("\n");
+    std::printf("  nodes           %llu\n", (unsigned long long)counts.nodes);
+    std::printf("  positions       %zu\n", counts.positions.count());
+    std::printf("  terminal        %zu\n", counts.terminals.count());
+    std::printf("  best time       %.3f ms\n", bestMs);
+    std::printf("  mean time       %.3f ms (%d iterations)\n", totalMs / iterations, iterations);
+    std::printf("  nodes/sec       %.0f\n", bestMs > 0.0 ? counts.nodes * 1000.0 / bestMs : 0.0);
+    std::printf("  %s\n", correct ? "ok" : "MISMATCH");
+    return correct;
+}
+
+//
+// run the walk a number of times and keep the fastest, which is the least noisy number
+//
+template<class Walk>
+static bool timeWalk(const char *label, int iterations, Walk &&perft)
+{
+    PerftCounts counts;
+    double bestMs = 0.0;
+    double totalMs = 0.0;
+    for (int i = 0; i < iterations; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        counts = perft();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        totalMs += ms;
+        if (i == 0 || ms < bestMs) bestMs = ms;
+    }
+    return report(label, counts, bestMs, totalMs, iterations);
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 20;
+    int threads = argc > 2 ? std::atoi(argv[2]) : 0;
+    if (iterations < 1) iterations = 1;
+    if (threads < 0) threads = 0;
+
+    ThreadPool pool((unsigned int)threads);
+
+    bool correct = timeWalk("single thread", iterations, []() { return perftSingle(); });
+    char label[64];
+    std::snprintf(label, sizeof(label), "%u threads", pool.size());
+    correct &= timeWalk(label, iterations, [&pool]() { return perftParallel(pool); });
+
+    return correct ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,92 @@
+//
+// tablebase: solves every 4x4 board (4 in a row) by retrograde analysis and writes the table the game maps at startup
+//
+// Before the real table, the same generator solves tic tac toe and checks every legal board's value
+// and distance to the end against the compile-time SolvedGame, so a broken generator never writes a file.
+// Run it from the directory the game runs in, the game looks for resources/tablebase_4x4x4.bin.
+//
+// usage: tablebase [output file] [threads]     threads 0 (the default) means one per hardware thread
+//
+#include "../classes/MNKTablebase.h"
+#include "../classes/SolvedGame.h"
+#include "../classes/ThreadPool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+static const char *kDefaultPath = "resources/tablebase_4x4x4.bin";
+
+static const char *valueName(int value)
+{
+    static const char *kNames[] = { "not stored", "win", "loss", "draw" };
+    return kNames[value];
+}
+
+//
+// every board SolvedGame knows about has to get the same value and the same number of plies to the end
+//
+static bool checkTicTacToe(ThreadPool &pool, const std::string &path)
+{
+    using Tablebase = MNKTablebase<3, 3, 3>;
+    Tablebase tablebase;
+    if (!Tablebase::generate(path, pool) || !tablebase.load(path))
+    {
+        std::printf("couldn't write %s\n", path.c_str());
+        return false;
+    }
+
+    int checked = 0;
+    int mismatches = 0;
+    for (int index = 0; index < TicTacToeBoard::kStates; index++)
+    {
+        TicTacToeBoard board = TicTacToeBoard::fromTernaryIndex(index);
+        if (SolvedGame::sideToMove(board) < 0) continue;
+        Tablebase::Probe probe = tablebase.probe(board);
+        int value = probe.value == Tablebase::kWin ? 1 : probe.value == Tablebase::kLoss ? -1 : 0;
+        bool stored = probe.value != Tablebase::kNotStored;
+        if (!stored || value != SolvedGame::value(board) || probe.pliesToEnd != SolvedGame::pliesToEnd(board)) mismatches++;
+        checked++;
+    }
+    tablebase.unload();
+    std::filesystem::remove(path);
+
+    std::printf("3x3 check        %d boards, %s\n", checked, mismatches ? "MISMATCH" : "ok");
+    return mismatches == 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::string path = argc > 1 ? argv[1] : kDefaultPath;
+    int threads = argc > 2 ? std::atoi(argv[2]) : 0;
+    if (threads < 0) threads = 0;
+
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent);
+
+    ThreadPool pool((unsigned int)threads);
+    if (!checkTicTacToe(pool, path + ".check")) return EXIT_FAILURE;
+
+    using Tablebase = MNKTablebase<4, 4, 4>;
+
+    auto start = std::chrono::steady_clock::now();
+    if (!Tablebase::generate(path, pool))
+    {
+        std::printf("couldn't write %s\n", path.c_str());
+        return EXIT_FAILURE;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    Tablebase tablebase;
+    if (!tablebase.load(path))
+    {
+        std::printf("couldn't map %s back in\n", path.c_str());
+        return EXIT_FAILURE;
+    }
+    Tablebase::Probe empty = tablebase.probe(Tablebase::Board());
+    std::printf("4x4 table        %llu boards, %.0f ms on %u threads\n", (unsigned long long)Tablebase::kStates, ms, pool.size());
+    std::printf("empty board      %s in %d plies, best move %d\n", valueName(empty.value), empty.pliesToEnd, tablebase.bestMove(Tablebase::Board()));
+    std::printf("written to       %s (%llu bytes)\n", path.c_str(), (unsigned long long)std::filesystem::file_size(path));
+    return EXIT_SUCCESS;
+}